@@ -0,0 +1,43 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <type_traits>
+
+namespace benchmark {
+using clock_type = std::chrono::steady_clock;
+
+/// Calls fct(i) for i in [0, iterations), prints and returns the average time of a call in nanoseconds.
+/// The values returned by fct are summed and printed, so that the calls can't be optimized away.
+template <typename Fct>
+inline double measure(const char* name, std::size_t iterations, Fct&& fct) {
+  double sum = 0;
+  const auto start = clock_type::now();
+
+  for (std::size_t i = 0; i < iterations; i++) {
+    if constexpr (std::is_void_v<std::invoke_result_t<Fct&, std::size_t>>) {
+      fct(i);
+    }
+    else {
+      sum += static_cast<double>(fct(i));
+    }
+  }
+
+  const double ns = std::chrono::duration<double, std::nano>(clock_type::now() - start).count()
+      / static_cast<double>(iterations);
+  std::printf("%-24s : %12.2f ns (%g)\n", name, ns, sum);
+  return ns;
+}
+} // namespace benchmark.
+
+/// Defines the main of a benchmark that can only run with the objc runtime.
+#ifdef __APPLE__
+  #define NANO_OBJC_BENCHMARK_REQUIRES_RUNTIME(name)
+#else
+  #define NANO_OBJC_BENCHMARK_REQUIRES_RUNTIME(name)                   \
+    int main() {                                                       \
+      std::printf("%s benchmark requires the objc runtime\n", name);   \
+      return 0;                                                        \
+    }
+#endif // __APPLE__
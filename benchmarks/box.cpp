@@ -0,0 +1,44 @@
+#include <nano/objc_box.h>
+#include "benchmark.h"
+
+NANO_OBJC_BENCHMARK_REQUIRES_RUNTIME("box")
+
+#ifdef __APPLE__
+namespace {
+namespace objc = nano::objc;
+
+constexpr std::size_t value_count = 1000000;
+
+inline int get_value(std::size_t i) { return static_cast<int>(i % 100000); }
+} // namespace
+
+int main() {
+  benchmark::measure("call_meta", value_count, [](std::size_t i) {
+    objc::obj_t* n = objc::call_meta<objc::obj_t*, int>("NSNumber", "numberWithInt:", get_value(i));
+    return objc::call<int>(n, "intValue");
+  });
+
+  benchmark::measure("box / unbox", value_count, [](std::size_t i) {
+    objc::obj_t* n = objc::box(get_value(i));
+    const int r = objc::unbox<int>(n);
+    objc::release(n);
+    return r;
+  });
+
+  benchmark::measure("box / unbox small", value_count, [](std::size_t i) {
+    objc::obj_t* n = objc::box(get_value(i) & 0xFF);
+    const int r = objc::unbox<int>(n);
+    objc::release(n);
+    return r;
+  });
+
+  benchmark::measure("box (double)", value_count, [](std::size_t i) {
+    objc::obj_t* n = objc::box(get_value(i) * 0.5);
+    const double r = objc::unbox<double>(n);
+    objc::release(n);
+    return r;
+  });
+
+  return 0;
+}
+#endif // __APPLE__
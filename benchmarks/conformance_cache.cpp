@@ -0,0 +1,50 @@
+#include <nano/objc.h>
+#include "benchmark.h"
+
+NANO_OBJC_BENCHMARK_REQUIRES_RUNTIME("conformance cache")
+
+#ifdef __APPLE__
+  #include <vector>
+
+namespace {
+namespace objc = nano::objc;
+
+constexpr std::size_t selector_count = 16;
+constexpr std::size_t event_count = 1000000;
+} // namespace
+
+int main() {
+  // Optional delegate callbacks, half of them implemented by NSString.
+  const char* names[selector_count] = { "length", "description", "hash", "copy", "uppercaseString", "UTF8String",
+    "intValue", "boolValue", "didReceiveEvent:", "willReceiveEvent:", "shouldHandleEvent:", "eventDidEnd:",
+    "eventWillBegin:", "eventWasCancelled:", "eventDidMove:", "eventDidResize:" };
+
+  std::vector<objc::selector_t*> selectors;
+  std::vector<objc::cached_selector> cached;
+  for (const char* n : names) {
+    selectors.push_back(objc::get_selector(n));
+    cached.push_back(objc::register_cached_selector(n));
+  }
+
+  objc::class_t* c = objc::get_class("NSString");
+
+  // 16 selectors per event.
+  benchmark::measure("runtime", event_count, [&](std::size_t) {
+    std::size_t count = 0;
+    for (objc::selector_t* sel : selectors) {
+      count += objc::responds_to_selector(c, sel);
+    }
+    return count;
+  });
+
+  benchmark::measure("cached", event_count, [&](std::size_t) {
+    std::size_t count = 0;
+    for (const objc::cached_selector& sel : cached) {
+      count += objc::responds_to_selector(c, sel);
+    }
+    return count;
+  });
+
+  return 0;
+}
+#endif // __APPLE__
@@ -0,0 +1,31 @@
+#include <nano/objc_data.h>
+#include "benchmark.h"
+
+NANO_OBJC_BENCHMARK_REQUIRES_RUNTIME("data view")
+
+#ifdef __APPLE__
+namespace {
+namespace objc = nano::objc;
+
+constexpr std::size_t buffer_size = 256 * 1024 * 1024;
+} // namespace
+
+int main() {
+  std::vector<std::byte> buffer(buffer_size, std::byte(1));
+
+  benchmark::measure("copy", 1, [&](std::size_t) {
+    objc::obj_t* data = objc::call<objc::obj_t*>(objc::call<objc::obj_t*>(objc::get_class("NSData"), "alloc"),
+        "initWithBytes:length:", static_cast<const void*>(buffer.data()), static_cast<objc::ns_uint_t>(buffer.size()));
+    const std::size_t size = objc::call<objc::ns_uint_t>(data, "length");
+    objc::release(data);
+    return size;
+  });
+
+  benchmark::measure(
+      "wrap", 1, [&](std::size_t) { return objc::data_view::wrap(buffer.data(), buffer.size()).size(); });
+
+  benchmark::measure("wrap (move)", 1, [&](std::size_t) { return objc::data_view::wrap(std::move(buffer)).size(); });
+
+  return 0;
+}
+#endif // __APPLE__
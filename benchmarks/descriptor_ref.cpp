@@ -0,0 +1,43 @@
+#include <nano/objc.h>
+#include "benchmark.h"
+
+NANO_OBJC_BENCHMARK_REQUIRES_RUNTIME("descriptor_ref")
+
+#ifdef __APPLE__
+namespace {
+namespace objc = nano::objc;
+
+constexpr std::size_t call_count = 10000000;
+
+struct counter_descriptor {
+  static constexpr const char* baseName = "NSObject";
+  static constexpr const char* valueName = "__counter";
+  static constexpr const char* className = "counter_descriptor";
+
+  long value = 0;
+
+  long add(long v) { return value += v; }
+};
+} // namespace
+
+int main() {
+  objc::class_descriptor<counter_descriptor> desc("CounterBenchmark");
+  desc.add_method<&counter_descriptor::add>("add:", "q@:q");
+  desc.register_class();
+
+  counter_descriptor counter;
+  objc::obj_t* obj = desc.create_instance();
+  objc::set_ivar_pointer(obj, counter_descriptor::valueName, &counter);
+
+  objc::selector_t* sel = objc::get_selector("add:");
+  benchmark::measure("objc::call", call_count,
+      [&](std::size_t i) { return objc::call<long>(obj, sel, static_cast<long>(i & 1)); });
+
+  objc::descriptor_ref<counter_descriptor> ref(obj);
+  benchmark::measure("descriptor_ref", call_count,
+      [&](std::size_t i) { return ref.call<&counter_descriptor::add>(sel, static_cast<long>(i & 1)); });
+
+  objc::release(obj);
+  return 0;
+}
+#endif // __APPLE__
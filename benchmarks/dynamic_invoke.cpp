@@ -0,0 +1,92 @@
+#include <nano/objc_invoke.h>
+#include "benchmark.h"
+
+namespace {
+namespace objc = nano::objc;
+using benchmark::measure;
+
+struct point {
+  double x, y;
+};
+
+double target(void*, void*, int a, point p, float f) { return a + p.x + p.y + static_cast<double>(f); }
+} // namespace
+
+int main() {
+  constexpr std::size_t iterations = 10000000;
+  volatile double sink = 0;
+
+  measure("parse signature", iterations / 10, [&](std::size_t) {
+    objc::method_signature sig("d40@0:8i16{point=dd}20f36");
+    sink = sink + static_cast<double>(sig.arguments_size());
+  });
+
+#ifdef __APPLE__
+  // What NSInvocation parses, the signatures are autoreleased.
+  objc::obj_t* pool = objc::call<objc::obj_t*>(objc::get_class("NSAutoreleasePool"), "new");
+  objc::class_t* signature_class = objc::get_class("NSMethodSignature");
+
+  measure("signatureWithObjCTypes:", iterations / 10, [&](std::size_t) {
+    objc::obj_t* sig
+        = objc::call<objc::obj_t*>(signature_class, "signatureWithObjCTypes:", "d40@0:8i16{point=dd}20f36");
+    sink = sink + static_cast<double>(objc::call<objc::ns_uint_t>(sig, "frameLength"));
+  });
+
+  objc::call(pool, "drain");
+#endif // __APPLE__
+
+  double (*volatile direct)(void*, void*, int, point, float) = &target;
+  measure("direct call", iterations, [&](std::size_t i) {
+    sink = sink + direct(nullptr, nullptr, static_cast<int>(i), point{ 1, 2 }, 0.5f);
+  });
+
+  objc::dynamic_invoker::prepared_call call;
+  objc::dynamic_invoker::prepare_signature(objc::method_signature("d@:i{point=dd}f"), call);
+  call.fct = reinterpret_cast<objc::dynamic_invoker::function_ptr>(&target);
+
+  struct {
+    int a;
+    point p;
+    float f;
+  } args = { 0, { 1, 2 }, 0.5f };
+
+  measure("dynamic_invoker", iterations, [&](std::size_t i) {
+    double result;
+    args.a = static_cast<int>(i);
+    objc::dynamic_invoker::invoke(call, nullptr, &args, &result);
+    sink = sink + result;
+  });
+
+#ifdef __APPLE__
+  objc::obj_t* str = objc::call<objc::obj_t*>(objc::get_class("NSString"), "stringWithUTF8String:", "benchmark");
+  objc::selector_t* sel = objc::get_selector("characterAtIndex:");
+  objc::dynamic_invoker invoker;
+
+  measure("objc_msgSend", iterations, [&](std::size_t i) {
+    sink = sink + objc::call<unsigned short>(str, sel, static_cast<unsigned long>(i % 9));
+  });
+
+  measure("dynamic_invoker (objc)", iterations, [&](std::size_t i) {
+    unsigned long index = i % 9;
+    unsigned short c = 0;
+    invoker.invoke(str, sel, &index, &c);
+    sink = sink + c;
+  });
+
+  objc::obj_t* method_sig = objc::call<objc::obj_t*>(str, "methodSignatureForSelector:", sel);
+  objc::obj_t* invocation
+      = objc::call<objc::obj_t*>(objc::get_class("NSInvocation"), "invocationWithMethodSignature:", method_sig);
+  objc::call(invocation, "setSelector:", sel);
+
+  measure("NSInvocation", iterations / 10, [&](std::size_t i) {
+    unsigned long index = i % 9;
+    unsigned short c = 0;
+    objc::call(invocation, "setArgument:atIndex:", static_cast<void*>(&index), 2L);
+    objc::call(invocation, "invokeWithTarget:", str);
+    objc::call(invocation, "getReturnValue:", static_cast<void*>(&c));
+    sink = sink + c;
+  });
+#endif // __APPLE__
+
+  return 0;
+}
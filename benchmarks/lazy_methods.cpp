@@ -0,0 +1,90 @@
+#include <nano/objc.h>
+#include "benchmark.h"
+
+NANO_OBJC_BENCHMARK_REQUIRES_RUNTIME("lazy methods")
+
+#ifdef __APPLE__
+  #include <string>
+  #include <utility>
+
+namespace {
+namespace objc = nano::objc;
+using benchmark::clock_type;
+
+constexpr std::size_t method_count = 500;
+constexpr std::size_t used_count = 10;
+
+struct eager_descriptor {
+  static constexpr const char* baseName = "NSObject";
+  static constexpr const char* valueName = "__eager";
+  static constexpr const char* className = "eager_descriptor";
+};
+
+struct lazy_descriptor {
+  static constexpr const char* baseName = "NSObject";
+  static constexpr const char* valueName = "__lazy";
+  static constexpr const char* className = "lazy_descriptor";
+};
+
+template <std::size_t I>
+long bench_method(objc::obj_t*, objc::selector_t*) {
+  return static_cast<long>(I);
+}
+
+const std::vector<std::string>& get_names() {
+  static const std::vector<std::string> names = [] {
+    std::vector<std::string> n;
+    for (std::size_t i = 0; i < method_count; i++) {
+      n.push_back("benchMethod" + std::to_string(i));
+    }
+    return n;
+  }();
+
+  return names;
+}
+
+template <bool Lazy, typename Descriptor, std::size_t... I>
+void add_methods(objc::class_descriptor<Descriptor>& desc, std::index_sequence<I...>) {
+  if constexpr (Lazy) {
+    (desc.template add_lazy_method<&bench_method<I>>(get_names()[I].c_str(), "q@:"), ...);
+  }
+  else {
+    (desc.template add_method<&bench_method<I>>(get_names()[I].c_str(), "q@:"), ...);
+  }
+}
+
+template <bool Lazy, typename Descriptor>
+void run(const char* name) {
+  const auto start = clock_type::now();
+  objc::class_descriptor<Descriptor> desc(name);
+  add_methods<Lazy>(desc, std::make_index_sequence<method_count>());
+  desc.register_class();
+  const auto registered = clock_type::now();
+
+  objc::obj_t* obj = desc.create_instance();
+  long sum = 0;
+  for (std::size_t i = 0; i < used_count; i++) {
+    sum += objc::call<long>(obj, get_names()[i * (method_count / used_count)].c_str());
+  }
+  const auto used = clock_type::now();
+
+  const objc::class_memory_info info = objc::get_class_memory_info(desc.get_class_object());
+  std::printf("%-6s : setup %8.1f us  first calls %8.1f us  methods %4zu  (%ld)\n", name,
+      std::chrono::duration<double, std::micro>(registered - start).count(),
+      std::chrono::duration<double, std::micro>(used - registered).count(), info.method_count, sum);
+
+  objc::release(obj);
+}
+} // namespace
+
+int main() {
+  // Registers the selectors so that both runs pay the same sel_registerName() cost.
+  for (const std::string& n : get_names()) {
+    nano::objc::get_selector(n.c_str());
+  }
+
+  run<false, eager_descriptor>("eager");
+  run<true, lazy_descriptor>("lazy");
+  return 0;
+}
+#endif // __APPLE__
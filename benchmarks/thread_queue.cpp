@@ -0,0 +1,78 @@
+#include <nano/objc_thread_queue.h>
+#include "benchmark.h"
+#include <algorithm>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace {
+namespace objc = nano::objc;
+using benchmark::clock_type;
+
+struct latency_stats {
+  std::vector<std::int64_t> samples;
+  std::size_t count = 0;
+};
+
+void record(void* receiver, void*, std::int64_t pushed) {
+  auto* stats = static_cast<latency_stats*>(receiver);
+  const auto now = static_cast<std::int64_t>(clock_type::now().time_since_epoch().count());
+
+  // Keep one sample out of 64 to avoid measuring the vector.
+  if ((stats->count++ & 63) == 0) {
+    stats->samples.push_back(now - pushed);
+  }
+}
+
+void run(std::size_t producer_count, std::size_t calls_per_producer) {
+  objc::thread_queue queue(8192, 256);
+  latency_stats stats;
+  stats.samples.reserve(producer_count * calls_per_producer / 64 + 1);
+
+  const std::size_t total = producer_count * calls_per_producer;
+  const auto start = clock_type::now();
+
+  std::vector<std::thread> producers;
+  for (std::size_t t = 0; t < producer_count; t++) {
+    producers.emplace_back([&]() {
+      for (std::size_t i = 0; i < calls_per_producer; i++) {
+        const auto now = static_cast<std::int64_t>(clock_type::now().time_since_epoch().count());
+        while (!queue.push(&stats, nullptr, &record, now)) {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+
+  std::size_t invoked = 0;
+  while (invoked < total) {
+    invoked += queue.pump();
+  }
+
+  const auto end = clock_type::now();
+
+  for (std::thread& t : producers) {
+    t.join();
+  }
+
+  std::sort(stats.samples.begin(), stats.samples.end());
+  const double seconds = std::chrono::duration<double>(end - start).count();
+  const auto percentile = [&](double p) {
+    return stats.samples.empty()
+        ? 0.0
+        : static_cast<double>(stats.samples[static_cast<std::size_t>(p * static_cast<double>(stats.samples.size() - 1))])
+            / 1000.0;
+  };
+
+  std::printf("producers %2zu : %8.2f Mcalls/s  latency p50 %8.2f us  p99 %8.2f us\n", producer_count,
+      static_cast<double>(total) / seconds / 1e6, percentile(0.5), percentile(0.99));
+}
+} // namespace
+
+int main() {
+  for (std::size_t producers : { 1, 2, 4, 8, 16 }) {
+    run(producers, 200000);
+  }
+
+  return 0;
+}
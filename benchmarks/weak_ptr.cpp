@@ -0,0 +1,57 @@
+#include <nano/objc_weak.h>
+#include "benchmark.h"
+
+NANO_OBJC_BENCHMARK_REQUIRES_RUNTIME("weak_ptr")
+
+#ifdef __APPLE__
+  #include <vector>
+
+namespace {
+namespace objc = nano::objc;
+
+constexpr std::size_t observer_count = 20;
+constexpr std::size_t event_count = 100000;
+} // namespace
+
+int main() {
+  std::vector<objc::obj_t*> observers;
+  std::vector<objc::weak_ptr> weak_observers;
+
+  for (std::size_t i = 0; i < observer_count; i++) {
+    observers.push_back(objc::create_object("NSObject", "init"));
+    weak_observers.emplace_back(observers.back());
+  }
+
+  // Observer list holding retained observers, retained again while notifying.
+  benchmark::measure("retained", event_count, [&](std::size_t) {
+    for (objc::obj_t* obj : observers) {
+      objc::retain(obj);
+    }
+
+    for (objc::obj_t* obj : observers) {
+      objc::release(obj);
+    }
+
+    return observers.size();
+  });
+
+  benchmark::measure("weak_ptr::lock_all", event_count, [&](std::size_t) {
+    objc::obj_t* locked[observer_count];
+    const std::size_t alive = objc::weak_ptr::lock_all(weak_observers.data(), weak_observers.size(), locked);
+
+    for (objc::obj_t* obj : locked) {
+      if (obj) {
+        objc::release(obj);
+      }
+    }
+
+    return alive;
+  });
+
+  for (objc::obj_t* obj : observers) {
+    objc::release(obj);
+  }
+
+  return 0;
+}
+#endif // __APPLE__
@@ -1,11 +1,15 @@
 #include <nano/objc.h>
+#include <nano/objc_invoke.h>
 
 #ifdef __APPLE__
 
   #include <CoreFoundation/CoreFoundation.h>
+  #include <dispatch/dispatch.h>
   #include <objc/message.h>
   #include <objc/objc.h>
   #include <objc/runtime.h>
+  #include <algorithm>
+  #include <malloc/malloc.h>
   #include <random>
 
 namespace nano::cf {
@@ -33,22 +37,404 @@ unique_ptr<CFDictionaryRef> create_dictionary(const void** keys, const void** va
 //
 //
 //
+extern "C" void* _NSConcreteStackBlock[32];
+
 namespace nano::objc {
 send_super_ptr send_super_fct = &objc_msgSendSuper;
 
+void* get_stack_block_isa() { return &_NSConcreteStackBlock; }
+
+void* get_main_queue() { return dispatch_get_main_queue(); }
+
+void dispatch_on_queue(void* queue, void* context, void (*fct)(void*)) {
+  dispatch_async_f(static_cast<dispatch_queue_t>(queue), context, fct);
+}
+
 proto_t* get_protocol(const char* name) { return objc_getProtocol(name); }
 
-bool add_protocol(class_t* c, proto_t* protocol) { return class_addProtocol(c, protocol); }
+bool add_protocol(class_t* c, proto_t* protocol) {
+  const bool added = class_addProtocol(c, protocol);
+  invalidate_runtime_caches();
+  return added;
+}
 
 void register_protocol(proto_t* protocol) { objc_registerProtocol(protocol); }
 
 proto_t* allocate_protocol(const char* name) { return objc_allocateProtocol(name); }
 
-class_t* allocate_class(class_t* super, const char* name) { return objc_allocateClassPair(super, name, 0); }
+namespace {
+  struct dynamic_class_entry {
+    class_t* cls;
+    std::atomic<std::ptrdiff_t>* live_instances;
+  };
+
+  struct dynamic_class_registry {
+    std::mutex mutex;
+    std::vector<dynamic_class_entry> entries;
+
+    /// Number of entries with a live instance counter, instances are only counted when non zero.
+    std::atomic<std::size_t> counter_count = 0;
+
+    static dynamic_class_registry& get() {
+      static dynamic_class_registry registry;
+      return registry;
+    }
+  };
+
+  /// Incremented by invalidate_runtime_caches(), see get_runtime_generation().
+  std::atomic<std::uint64_t> runtime_generation = 1;
+
+  /// Per class responds-to / conforms-to results of the cached selectors and protocols.
+  ///
+  /// Each word holds the generation it was filled in (top 24 bits) and 2 bits per key (known, value).
+  /// A word filled in an older runtime generation is ignored, invalidate_runtime_caches() is a single increment.
+  class conformance_table {
+  public:
+    static constexpr std::uint32_t invalid_key = ~std::uint32_t(0);
+    static constexpr std::size_t capacity = 1024;
+    static constexpr std::size_t max_probes = 32;
+    static constexpr std::size_t words_per_class = 8;
+    static constexpr std::size_t keys_per_word = 20;
+    static constexpr std::size_t max_keys = words_per_class * keys_per_word;
+    static constexpr unsigned generation_shift = 40;
+    static constexpr std::uint64_t generation_mask = (std::uint64_t(1) << 24) - 1;
+
+    static conformance_table& get() {
+      static conformance_table table;
+      return table;
+    }
+
+    std::uint32_t new_key() {
+      const std::uint32_t key = m_key_count.fetch_add(1, std::memory_order_relaxed);
+      return key < max_keys ? key : invalid_key;
+    }
+
+    template <typename Fct>
+    bool get(class_t* c, std::uint32_t key, Fct&& compute) {
+      entry* e = key == invalid_key || !c ? nullptr : find(c);
+      if (!e) {
+        return compute();
+      }
+
+      const std::uint64_t generation = get_runtime_generation() & generation_mask;
+      std::atomic<std::uint64_t>& word = e->words[key / keys_per_word];
+      const unsigned shift = static_cast<unsigned>(key % keys_per_word) * 2;
+
+      std::uint64_t value = word.load(std::memory_order_acquire);
+      if ((value >> generation_shift) == generation && ((value >> shift) & 2)) {
+        return ((value >> shift) & 1) != 0;
+      }
+
+      const bool result = compute();
+      const std::uint64_t bits = (std::uint64_t(2) | std::uint64_t(result)) << shift;
+
+      for (;;) {
+        // The class was mutated while computing, the result may already be stale.
+        if ((get_runtime_generation() & generation_mask) != generation) {
+          return result;
+        }
+
+        const std::uint64_t desired
+            = (value >> generation_shift) == generation ? value | bits : (generation << generation_shift) | bits;
+
+        if (word.compare_exchange_weak(value, desired, std::memory_order_acq_rel, std::memory_order_acquire)) {
+          return result;
+        }
+      }
+    }
+
+    /// Turns the entry of a disposed class into a tombstone, reused by the next inserted class.
+    /// Must be called after invalidating, a class reusing the entry never sees the results of c.
+    void erase(class_t* c) {
+      const std::size_t h = hash(c);
+
+      for (std::size_t i = 0; i < max_probes; i++) {
+        entry& e = m_entries[(h + i) & (capacity - 1)];
+        class_t* k = e.cls.load(std::memory_order_acquire);
+
+        if (!k) {
+          return;
+        }
+
+        if (k == c) {
+          for (std::atomic<std::uint64_t>& word : e.words) {
+            word.store(0, std::memory_order_relaxed);
+          }
+
+          e.cls.compare_exchange_strong(k, tombstone(), std::memory_order_acq_rel);
+        }
+      }
+    }
+
+  private:
+    struct entry {
+      std::atomic<class_t*> cls;
+      std::atomic<std::uint64_t> words[words_per_class];
+    };
+
+    std::unique_ptr<entry[]> m_entries = std::make_unique<entry[]>(capacity);
+    std::atomic<std::uint32_t> m_key_count = 0;
+
+    static inline class_t* tombstone() noexcept { return reinterpret_cast<class_t*>(std::uintptr_t(1)); }
+
+    static inline std::size_t hash(class_t* c) noexcept {
+      return (reinterpret_cast<std::size_t>(c) >> 4) * 0x9E3779B97F4A7C15ULL;
+    }
+
+    static inline bool claim(entry& e, class_t* expected, class_t* c) noexcept {
+      return e.cls.compare_exchange_strong(expected, c, std::memory_order_acq_rel) || expected == c;
+    }
+
+    /// Finds or inserts the entry of a class, nullptr when the table is full.
+    /// Tombstones are skipped by lookups, the first one is reused when c isn't in the table.
+    entry* find(class_t* c) {
+      const std::size_t h = hash(c);
+      entry* reusable = nullptr;
+
+      for (std::size_t i = 0; i < max_probes; i++) {
+        entry& e = m_entries[(h + i) & (capacity - 1)];
+        class_t* k = e.cls.load(std::memory_order_acquire);
+
+        if (k == c) {
+          return &e;
+        }
+
+        if (k == tombstone()) {
+          reusable = reusable ? reusable : &e;
+          continue;
+        }
+
+        if (!k) {
+          // c isn't further in the probe sequence.
+          if (reusable && claim(*reusable, tombstone(), c)) {
+            return reusable;
+          }
+
+          if (claim(e, nullptr, c)) {
+            return &e;
+          }
+        }
+      }
+
+      if (reusable && claim(*reusable, tombstone(), c)) {
+        return reusable;
+      }
+
+      return nullptr;
+    }
+  };
+} // namespace.
+
+cached_selector register_cached_selector(const char* name) {
+  return { get_selector(name), conformance_table::get().new_key() };
+}
+
+cached_protocol register_cached_protocol(const char* name) {
+  return { get_protocol(name), conformance_table::get().new_key() };
+}
+
+bool responds_to_selector(class_t* c, const cached_selector& sel) {
+  return conformance_table::get().get(c, sel.key, [&] { return class_respondsToSelector(c, sel.sel); });
+}
+
+bool conforms_to_protocol(class_t* c, const cached_protocol& protocol) {
+  return protocol.protocol
+      && conformance_table::get().get(c, protocol.key, [&] { return class_conformsToProtocol(c, protocol.protocol); });
+}
+
+void invalidate_runtime_caches() { runtime_generation.fetch_add(1, std::memory_order_acq_rel); }
+
+std::uint64_t get_runtime_generation() noexcept { return runtime_generation.load(std::memory_order_acquire); }
+
+class_t* allocate_class(class_t* super, const char* name) {
+  class_t* c = objc_allocateClassPair(super, name, 0);
+
+  if (c) {
+    dynamic_class_registry& registry = dynamic_class_registry::get();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.entries.push_back({ c, nullptr });
+  }
+
+  return c;
+}
 
 void register_class(class_t* c) { objc_registerClassPair(c); }
 
-void dispose_class(class_t* c) { objc_disposeClassPair(c); }
+void dispose_class(class_t* c) {
+  {
+    dynamic_class_registry& registry = dynamic_class_registry::get();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.entries.erase(std::remove_if(registry.entries.begin(), registry.entries.end(),
+                               [&](const dynamic_class_entry& e) {
+                                 if (e.cls != c) {
+                                   return false;
+                                 }
+
+                                 if (e.live_instances) {
+                                   registry.counter_count.fetch_sub(1, std::memory_order_relaxed);
+                                 }
+
+                                 return true;
+                               }),
+        registry.entries.end());
+  }
+
+  objc_disposeClassPair(c);
+
+  // The address of the class can be reused.
+  invalidate_runtime_caches();
+  conformance_table::get().erase(c);
+}
+
+void set_class_instance_counter(class_t* c, std::atomic<std::ptrdiff_t>* counter) {
+  dynamic_class_registry& registry = dynamic_class_registry::get();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+
+  for (dynamic_class_entry& e : registry.entries) {
+    if (e.cls == c) {
+      registry.counter_count.fetch_add(
+          std::size_t(counter != nullptr) - std::size_t(e.live_instances != nullptr), std::memory_order_relaxed);
+      e.live_instances = counter;
+      return;
+    }
+  }
+}
+
+std::vector<class_t*> get_dynamic_classes() {
+  dynamic_class_registry& registry = dynamic_class_registry::get();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+
+  std::vector<class_t*> classes;
+  classes.reserve(registry.entries.size());
+
+  for (const dynamic_class_entry& e : registry.entries) {
+    classes.push_back(e.cls);
+  }
+
+  return classes;
+}
+
+class_memory_info get_class_memory_info(class_t* c) {
+  class_memory_info info = {};
+  info.name = class_getName(c);
+  info.instance_size = class_getInstanceSize(c);
+
+  unsigned int methodCount = 0;
+  std::free(class_copyMethodList(c, &methodCount));
+  info.method_count = methodCount;
+
+  unsigned int ivarCount = 0;
+  if (Ivar* ivars = class_copyIvarList(c, &ivarCount)) {
+    for (unsigned int i = 0; i < ivarCount; i++) {
+      info.ivars.push_back({ ivar_getName(ivars[i]), ivar_getTypeEncoding(ivars[i]), ivar_getOffset(ivars[i]),
+          get_encoding_size(ivar_getTypeEncoding(ivars[i])), 0 });
+    }
+
+    std::free(ivars);
+  }
+
+  std::sort(info.ivars.begin(), info.ivars.end(),
+      [](const ivar_layout_info& a, const ivar_layout_info& b) { return a.offset < b.offset; });
+
+  // Bytes between the superclass instance and the first ivar.
+  if (!info.ivars.empty()) {
+    const std::size_t superSize = class_getInstanceSize(class_getSuperclass(c));
+    const std::size_t first = static_cast<std::size_t>(info.ivars.front().offset);
+    info.padding = first > superSize ? first - superSize : 0;
+  }
+
+  for (std::size_t i = 0; i < info.ivars.size(); i++) {
+    ivar_layout_info& iv = info.ivars[i];
+    const std::size_t begin = static_cast<std::size_t>(iv.offset);
+    const std::size_t end = i + 1 < info.ivars.size() ? static_cast<std::size_t>(info.ivars[i + 1].offset)
+                                                      : info.instance_size;
+
+    if (iv.size == 0 || begin + iv.size > end) {
+      iv.size = end - begin;
+    }
+
+    iv.padding = end - begin - iv.size;
+    info.padding += iv.padding;
+  }
+
+  dynamic_class_registry& registry = dynamic_class_registry::get();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+
+  for (const dynamic_class_entry& e : registry.entries) {
+    if (e.cls == c && e.live_instances) {
+      info.live_instances
+          = static_cast<std::size_t>(std::max<std::ptrdiff_t>(e.live_instances->load(std::memory_order_relaxed), 0));
+      info.bytes_in_use = info.live_instances * malloc_good_size(info.instance_size);
+    }
+  }
+
+  return info;
+}
+
+memory_snapshot take_memory_snapshot() {
+  dynamic_class_registry& registry = dynamic_class_registry::get();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+
+  memory_snapshot snapshot;
+  snapshot.classes.reserve(registry.entries.size());
+
+  for (const dynamic_class_entry& e : registry.entries) {
+    const std::size_t size = class_getInstanceSize(e.cls);
+    const std::ptrdiff_t live = e.live_instances ? e.live_instances->load(std::memory_order_relaxed) : 0;
+    snapshot.classes.push_back(
+        { e.cls, class_getName(e.cls), size, live, live * static_cast<std::ptrdiff_t>(malloc_good_size(size)) });
+  }
+
+  return snapshot;
+}
+
+memory_snapshot diff_memory_snapshots(const memory_snapshot& before, const memory_snapshot& after) {
+  memory_snapshot diff;
+
+  for (const class_memory_usage& a : after.classes) {
+    class_memory_usage d = a;
+
+    auto it = std::find_if(before.classes.begin(), before.classes.end(),
+        [&](const class_memory_usage& b) { return b.cls == a.cls; });
+
+    if (it != before.classes.end()) {
+      d.live_instances -= it->live_instances;
+      d.bytes_in_use -= it->bytes_in_use;
+    }
+
+    if (d.live_instances || d.bytes_in_use) {
+      diff.classes.push_back(d);
+    }
+  }
+
+  // Disposed classes.
+  for (const class_memory_usage& b : before.classes) {
+    auto it = std::find_if(
+        after.classes.begin(), after.classes.end(), [&](const class_memory_usage& a) { return b.cls == a.cls; });
+
+    if (it == after.classes.end() && (b.live_instances || b.bytes_in_use)) {
+      diff.classes.push_back({ b.cls, b.name, b.instance_size, -b.live_instances, -b.bytes_in_use });
+    }
+  }
+
+  return diff;
+}
+
+std::ptrdiff_t memory_snapshot::live_instances() const noexcept {
+  std::ptrdiff_t count = 0;
+  for (const class_memory_usage& c : classes) {
+    count += c.live_instances;
+  }
+  return count;
+}
+
+std::ptrdiff_t memory_snapshot::bytes_in_use() const noexcept {
+  std::ptrdiff_t bytes = 0;
+  for (const class_memory_usage& c : classes) {
+    bytes += c.bytes_in_use;
+  }
+  return bytes;
+}
 
 const char* get_class_name(class_t* c) { return class_getName(c); }
 
@@ -56,11 +442,37 @@ bool responds_to_selector(class_t* c, selector_t* sel) { return class_respondsTo
 
 bool conforms_to_protocol(class_t* c, proto_t* protocol) { return class_conformsToProtocol(c, protocol); }
 
-obj_t* create_class_instance(class_t* c) { return class_createInstance(c, 0); }
+namespace {
+  /// class_createInstance() doesn't go through +allocWithZone:, the instance is counted here.
+  /// The counter is the one of c or of its closest superclass, same as the dealloc of a class_descriptor.
+  obj_t* create_counted_instance(class_t* c, std::size_t extraBytes) {
+    obj_t* obj = class_createInstance(c, extraBytes);
+    dynamic_class_registry& registry = dynamic_class_registry::get();
+
+    if (!obj || registry.counter_count.load(std::memory_order_relaxed) == 0) {
+      return obj;
+    }
+
+    std::lock_guard<std::mutex> lock(registry.mutex);
+
+    for (; c; c = class_getSuperclass(c)) {
+      for (const dynamic_class_entry& e : registry.entries) {
+        if (e.cls == c && e.live_instances) {
+          e.live_instances->fetch_add(1, std::memory_order_relaxed);
+          return obj;
+        }
+      }
+    }
+
+    return obj;
+  }
+} // namespace.
+
+obj_t* create_class_instance(class_t* c) { return create_counted_instance(c, 0); }
 
-obj_t* create_class_instance(class_t* c, std::size_t extraBytes) { return class_createInstance(c, extraBytes); }
+obj_t* create_class_instance(class_t* c, std::size_t extraBytes) { return create_counted_instance(c, extraBytes); }
 
-obj_t* create_class_instance(const char* name) { return class_createInstance(get_class(name), 0); }
+obj_t* create_class_instance(const char* name) { return create_counted_instance(get_class(name), 0); }
 
 bool add_class_pointer(class_t* c, const char* name, const char* className, std::size_t size, std::size_t align) {
   std::string enc = "^{" + std::string(className) + "=}";
@@ -75,12 +487,32 @@ class_t* get_class(const char* name) { return objc_getClass(name); }
 
 class_t* get_meta_class(const char* name) { return objc_getMetaClass(name); }
 
+class_t* get_superclass(class_t* c) { return class_getSuperclass(c); }
+
 selector_t* get_selector(const char* name) { return sel_registerName(name); }
 
+const char* get_selector_name(selector_t* sel) { return sel_getName(sel); }
+
 imp_ptr get_class_method_implementation(class_t* c, selector_t* s) { return class_getMethodImplementation(c, s); }
 
+imp_ptr get_class_method_implementation_stret(class_t* c, selector_t* s) {
+  #if defined(__x86_64__) || defined(__i386__)
+  return class_getMethodImplementation_stret(c, s);
+  #else
+  return class_getMethodImplementation(c, s);
+  #endif
+}
+
 bool add_class_method(class_t* c, selector_t* s, imp_ptr imp, const char* types) {
-  return class_addMethod(c, s, imp, types);
+  const bool added = class_addMethod(c, s, imp, types);
+  invalidate_runtime_caches();
+  return added;
+}
+
+imp_ptr replace_class_method(class_t* c, selector_t* s, imp_ptr imp, const char* types) {
+  imp_ptr previous = class_replaceMethod(c, s, imp, types);
+  invalidate_runtime_caches();
+  return previous;
 }
 
 class_t* get_obj_class(obj_t* obj) { return object_getClass(obj); }
@@ -127,6 +559,111 @@ void* get_obj_indexed_variables(obj_t* obj) { return object_getIndexedIvars(obj)
 
 void obj_deleter::operator()(obj_t* obj) const noexcept { objc::release(obj); }
 
+namespace {
+  inline void retain_if(obj_t* obj) {
+    if (obj) {
+      objc::retain(obj);
+    }
+  }
+
+  inline void release_if(obj_t* obj) {
+    if (obj) {
+      objc::release(obj);
+    }
+  }
+} // namespace.
+
+event_coalescer::event_coalescer(deliver_ptr fct, double window, void* runLoop)
+    : m_deliver(fct)
+    , m_window(window)
+    , m_run_loop(const_cast<void*>(CFRetain(runLoop ? runLoop : CFRunLoopGetMain()))) {}
+
+event_coalescer::~event_coalescer() {
+  if (m_timer) {
+    CFRunLoopTimerInvalidate(static_cast<CFRunLoopTimerRef>(m_timer));
+    CFRelease(m_timer);
+  }
+
+  CFRelease(m_run_loop);
+
+  for (const event& e : m_events) {
+    release_if(e.receiver);
+    release_if(e.name);
+    release_if(e.object);
+    release_if(e.payload);
+  }
+}
+
+void event_coalescer::set_window(double window) noexcept { m_window.store(window, std::memory_order_relaxed); }
+
+void event_coalescer::post(obj_t* receiver, obj_t* name, obj_t* object, obj_t* payload) {
+  obj_t* replaced = nullptr;
+
+  retain_if(payload);
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = std::find_if(m_events.begin(), m_events.end(), [&](const event& e) {
+      return e.receiver == receiver && e.name == name && e.object == object;
+    });
+
+    if (it != m_events.end()) {
+      replaced = it->payload;
+      it->payload = payload;
+      it->count++;
+    }
+    else {
+      retain_if(receiver);
+      retain_if(name);
+      retain_if(object);
+      m_events.push_back({ receiver, name, object, payload, 1 });
+    }
+
+    if (!m_timer) {
+      schedule(m_window.load(std::memory_order_relaxed));
+    }
+  }
+
+  // Released outside the lock since it may dealloc.
+  release_if(replaced);
+}
+
+void event_coalescer::schedule(double window) {
+  CFRunLoopTimerContext context = {};
+  context.info = this;
+
+  CFRunLoopTimerRef timer = CFRunLoopTimerCreate(kCFAllocatorDefault, CFAbsoluteTimeGetCurrent() + window, 0, 0, 0,
+      [](CFRunLoopTimerRef, void* info) { static_cast<event_coalescer*>(info)->flush(); }, &context);
+
+  CFRunLoopAddTimer(static_cast<CFRunLoopRef>(m_run_loop), timer, kCFRunLoopCommonModes);
+  m_timer = timer;
+}
+
+void event_coalescer::flush() {
+  std::vector<event> events;
+  void* timer = nullptr;
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    events.swap(m_events);
+    std::swap(timer, m_timer);
+  }
+
+  if (timer) {
+    CFRunLoopTimerInvalidate(static_cast<CFRunLoopTimerRef>(timer));
+    CFRelease(timer);
+  }
+
+  for (const event& e : events) {
+    m_deliver(e.receiver, e.name, e.object, e.payload, e.count);
+
+    release_if(e.receiver);
+    release_if(e.name);
+    release_if(e.object);
+    release_if(e.payload);
+  }
+}
+
 std::string generate_random_alphanum_string(std::size_t length) {
   static const char alphanum[] = "0123456789"
                                  "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
@@ -22,8 +22,17 @@
  */
 
 #include <nano/common.h>
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <string_view>
+#include <utility>
+#include <vector>
 
 #ifdef __APPLE__
 
@@ -135,11 +144,20 @@ namespace objc {
   void dispose_class(class_t* c);
   class_t* get_class(const char* name);
   class_t* get_meta_class(const char* name);
+  class_t* get_superclass(class_t* c);
   const char* get_class_name(class_t* c);
 
   imp_ptr get_class_method_implementation(class_t* c, selector_t* s);
 
+  /// Same as get_class_method_implementation() for methods returning a struct in memory.
+  /// The returned imp only differs when the method is forwarded on architectures using objc_msgSend_stret.
+  imp_ptr get_class_method_implementation_stret(class_t* c, selector_t* s);
+
   bool add_class_method(class_t* c, selector_t* s, imp_ptr imp, const char* types);
+
+  /// Adds or replaces a method.
+  /// @returns The previous implementation of the method if it was defined by the class itself, nullptr otherwise.
+  imp_ptr replace_class_method(class_t* c, selector_t* s, imp_ptr imp, const char* types);
   bool add_class_pointer(class_t* c, const char* name, const char* className, std::size_t size, std::size_t align);
   bool add_class_variable(class_t* c, const char* name, const char* encoding, std::size_t size, std::size_t align);
 
@@ -152,9 +170,43 @@ namespace objc {
   void register_protocol(proto_t* protocol);
 
   selector_t* get_selector(const char* name);
+  const char* get_selector_name(selector_t* sel);
   bool responds_to_selector(class_t* c, selector_t* sel);
   bool conforms_to_protocol(class_t* c, proto_t* protocol);
 
+  /// Invalidates the results cached for all classes, i.e. the conformance cache (cached_selector and
+  /// cached_protocol) and the calls prepared by dynamic_invoker.
+  /// Called by add_class_method(), replace_class_method(), add_protocol() and dispose_class(),
+  /// must be called after mutating a class with the objc runtime directly.
+  void invalidate_runtime_caches();
+
+  /// Incremented by invalidate_runtime_caches(), i.e. each time a class is mutated or disposed.
+  /// Caches of per class results store the generation they were filled in, they are stale once it changed.
+  std::uint64_t get_runtime_generation() noexcept;
+
+  /// A selector whose responds_to_selector() result is cached per class.
+  struct cached_selector {
+    selector_t* sel;
+    std::uint32_t key;
+  };
+
+  /// A protocol whose conforms_to_protocol() result is cached per class.
+  struct cached_protocol {
+    proto_t* protocol;
+    std::uint32_t key;
+  };
+
+  /// Registers a selector or protocol in the conformance cache, usually stored in a static variable.
+  /// The protocol must already exist.
+  /// The first 160 registered selectors and protocols are cached, the following ones are not.
+  cached_selector register_cached_selector(const char* name);
+  cached_protocol register_cached_protocol(const char* name);
+
+  /// Cached versions of responds_to_selector() and conforms_to_protocol(), safe to call from any thread.
+  /// After the first query for a class, a check is a few loads and no runtime call.
+  bool responds_to_selector(class_t* c, const cached_selector& sel);
+  bool conforms_to_protocol(class_t* c, const cached_protocol& protocol);
+
   obj_t* create_class_instance(class_t* c);
   obj_t* create_class_instance(class_t* c, std::size_t extraBytes);
   obj_t* create_class_instance(const char* name);
@@ -198,6 +250,73 @@ namespace objc {
   //
   //
 
+  /// Instance variable of a class, in offset order.
+  struct ivar_layout_info {
+    const char* name;
+    const char* encoding;
+    std::ptrdiff_t offset;
+
+    /// Size of the ivar type, or the distance to the next ivar if the size can't be deduced from the encoding.
+    std::size_t size;
+
+    /// Unused bytes between the end of this ivar and the next one (or the end of the instance).
+    std::size_t padding;
+  };
+
+  /// Detailed memory information of a class created with allocate_class().
+  struct class_memory_info {
+    const char* name;
+    std::size_t instance_size;
+    std::size_t method_count;
+
+    /// Total of unused bytes in the ivars declared by the class.
+    std::size_t padding;
+    std::vector<ivar_layout_info> ivars;
+
+    /// Only tracked for class_descriptor classes, zero otherwise.
+    std::size_t live_instances;
+    std::size_t bytes_in_use;
+  };
+
+  /// Instance usage of a class created with allocate_class().
+  struct class_memory_usage {
+    class_t* cls;
+    const char* name;
+    std::size_t instance_size;
+    std::ptrdiff_t live_instances;
+    std::ptrdiff_t bytes_in_use;
+  };
+
+  /// Instance usage of all the classes created with allocate_class().
+  /// Taking a snapshot doesn't copy any string, it's cheap enough to be done periodically.
+  struct memory_snapshot {
+    std::vector<class_memory_usage> classes;
+
+    std::ptrdiff_t live_instances() const noexcept;
+    std::ptrdiff_t bytes_in_use() const noexcept;
+  };
+
+  /// Returns all the classes created with allocate_class() that were not disposed.
+  std::vector<class_t*> get_dynamic_classes();
+
+  class_memory_info get_class_memory_info(class_t* c);
+
+  memory_snapshot take_memory_snapshot();
+
+  /// Returns the per class difference between two snapshots (after - before).
+  /// Classes without any change are omitted.
+  memory_snapshot diff_memory_snapshots(const memory_snapshot& before, const memory_snapshot& after);
+
+  /// Sets the live instance counter of a class created with allocate_class().
+  /// create_class_instance() increments the counter of the class or of its closest superclass with a counter,
+  /// the class is responsible for decrementing it (e.g. in dealloc) and for counting instances created with +alloc.
+  /// The counter must outlive the class, nullptr removes it.
+  void set_class_instance_counter(class_t* c, std::atomic<std::ptrdiff_t>* counter);
+
+  //
+  //
+  //
+
   template <class _Tp>
   using null_to_obj = std::conditional_t<std::is_null_pointer_v<_Tp>, obj_t*, _Tp>;
 
@@ -232,6 +351,95 @@ namespace objc {
   template <typename R = void, typename... Args, typename... Params>
   inline R call_meta(const char* className, const char* selectorName, Params&&... params);
 
+  /// Coalesces events by (receiver, name, object) and delivers them once per window.
+  ///
+  /// The first event of a burst schedules a timer on the run loop of the coalescer (the main run loop by default),
+  /// all events received until it fires are delivered with the last payload and the number of events.
+  /// Events can be posted from any thread, they are always delivered on the thread of that run loop.
+  /// A window of zero delivers on the next run loop turn.
+  ///
+  /// @remarks Names and objects are compared by address.
+  ///          Receiver, name, object and payload are retained until delivery.
+  class event_coalescer {
+  public:
+    using deliver_ptr = void (*)(obj_t* receiver, obj_t* name, obj_t* object, obj_t* payload, std::size_t count);
+
+    /// @param runLoop The CFRunLoopRef delivering the events, nullptr for the main run loop.
+    event_coalescer(deliver_ptr fct, double window = 0, void* runLoop = nullptr);
+
+    event_coalescer(const event_coalescer&) = delete;
+
+    ~event_coalescer();
+
+    event_coalescer& operator=(const event_coalescer&) = delete;
+
+    void set_window(double window) noexcept;
+
+    void post(obj_t* receiver, obj_t* name, obj_t* object, obj_t* payload);
+
+    /// Delivers all pending events now.
+    void flush();
+
+  private:
+    struct event {
+      obj_t* receiver;
+      obj_t* name;
+      obj_t* object;
+      obj_t* payload;
+      std::size_t count;
+    };
+
+    deliver_ptr m_deliver;
+    std::atomic<double> m_window;
+    void* m_run_loop;
+    std::mutex m_mutex;
+    std::vector<event> m_events;
+    void* m_timer = nullptr;
+
+    void schedule(double window);
+  };
+
+  //
+  //
+  //
+
+  /// Descriptor of a block literal without copy/dispose helpers.
+  struct block_descriptor {
+    unsigned long reserved;
+    unsigned long size;
+  };
+
+  /// A clang block literal calling back into C++.
+  /// The context pointer is copied along with the block when the callee calls Block_copy().
+  ///
+  /// @remarks A block_literal is a stack block, it can be passed as an obj_t* to any
+  ///          method expecting a block as long as it outlives the call.
+  template <typename R, typename... Args>
+  struct block_literal {
+    using invoke_ptr = R (*)(block_literal*, Args...);
+
+    void* isa;
+    int flags;
+    int reserved;
+    invoke_ptr invoke;
+    const block_descriptor* descriptor;
+    void* context;
+
+    inline obj_t* get() { return reinterpret_cast<obj_t*>(this); }
+  };
+
+  template <typename R, typename... Args>
+  inline block_literal<R, Args...> make_block(typename block_literal<R, Args...>::invoke_ptr invoke, void* context);
+
+  /// Returns the isa of stack blocks (i.e. _NSConcreteStackBlock).
+  void* get_stack_block_isa();
+
+  /// Returns the main dispatch queue.
+  void* get_main_queue();
+
+  /// Calls dispatch_async_f() on the given dispatch queue.
+  void dispatch_on_queue(void* queue, void* context, void (*fct)(void*));
+
   ///
   template <typename Descriptor>
   class class_descriptor {
@@ -246,8 +454,19 @@ namespace objc {
 
     obj_t* create_instance() const;
 
+    inline class_t* get_class_object() const noexcept { return m_classObject; }
+
+    /// Calls the superclass implementation of a method.
+    ///
+    /// The superclass and the superclass implementation of each selector are resolved on first use,
+    /// subsequent calls are a direct imp invocation.
+    template <typename ReturnType, typename... Args, typename... Params>
+    static ReturnType send_superclass_message(obj_t* obj, selector_t* sel, Params&&... params);
+
+    /// Same as above, the selector of each name is cached by the address of the name.
+    /// Prefer the selector_t* version (e.g. the _cmd of an override), a name is compared on every call.
     template <typename ReturnType, typename... Args, typename... Params>
-    static ReturnType send_superclass_message(obj_t* obj, const char* selectorName, Params&&... params);
+    static inline ReturnType send_superclass_message(obj_t* obj, const char* selectorName, Params&&... params);
 
     template <typename Type>
     inline bool add_pointer(const char* name, const char* className);
@@ -255,19 +474,237 @@ namespace objc {
     template <auto FunctionType>
     inline bool add_method(const char* selectorName, const char* signature);
 
+    /// Same as add_method() but the method is only added to the class the first time it is looked up
+    /// (from +resolveInstanceMethod:). Large descriptors only pay for the methods that are actually used.
+    ///
+    /// @remarks The selector name and signature must have static storage duration (e.g. literals).
+    ///          Must be called before register_class().
+    template <auto FunctionType>
+    inline void add_lazy_method(const char* selectorName, const char* signature);
+
     template <void (Descriptor::*MemberFunctionPointer)(obj_t*)>
     bool add_notification_method(const char* selectorName);
 
+    /// Coalesced version of add_notification_method().
+    /// Notifications with the same (name, object) received within the window are delivered once
+    /// with the last notification and the number of notifications received, on the main thread.
+    ///
+    /// @remarks Must be called before register_class().
+    template <void (Descriptor::*MemberFunctionPointer)(obj_t* notification, std::size_t count)>
+    bool add_coalesced_notification_method(const char* selectorName, double window = 0);
+
+    /// Adds observeValueForKeyPath:ofObject:change:context: with changes coalesced by (keyPath, object).
+    /// The last change dictionary is delivered along with the number of changes received within the window,
+    /// on the main thread.
+    ///
+    /// @remarks Must be called before register_class().
+    template <void (Descriptor::*MemberFunctionPointer)(
+        obj_t* keyPath, obj_t* object, obj_t* change, std::size_t count)>
+    bool add_coalesced_observer_method(double window = 0);
+
+    /// Forwards messages the class doesn't implement to another object through forwardingTargetForSelector:,
+    /// the message is resent to the target without building an NSInvocation.
+    ///
+    /// TargetFunction is either an `obj_t* (Descriptor::*)()` or an `obj_t* (*)(obj_t* self)` returning the
+    /// target of an instance. Returning nil falls back to the regular forwarding path (forwardInvocation:).
+    ///
+    /// When selectorNames is empty, TargetFunction is the default target of all unknown selectors.
+    /// Otherwise only these selectors are forwarded to it, and respondsToSelector: returns true for them
+    /// when the target responds to them.
+    ///
+    /// @remarks Must be called before register_class().
+    template <auto TargetFunction>
+    bool add_forwarding_target(std::initializer_list<const char*> selectorNames = {});
+
+    /// Forwards a selector to a C++ function (same as add_method()) through forwardingTargetForSelector:.
+    ///
+    /// Handlers are methods of a hidden forwarder object shared by the instances of the class. The message
+    /// is resent to the forwarder without building an NSInvocation, and the handler is called with the
+    /// original receiver. The class itself doesn't implement the selector.
+    ///
+    /// @remarks Must be called before register_class().
+    template <auto FunctionType>
+    bool add_forwarding_handler(const char* selectorName, const char* signature);
+
     inline bool add_protocol(const char* protocolName, bool force = false);
 
     inline bool register_class();
 
+    /// Returns true if c is a registered class of this Descriptor (subclasses excluded).
+    static inline bool is_descriptor_class(class_t* c) noexcept;
+
   private:
+    struct lazy_method {
+      const char* name;
+      imp_ptr imp;
+      const char* signature;
+    };
+
+    using forwarding_target_ptr = obj_t* (*)(obj_t*);
+
+    struct forwarding_entry {
+      selector_t* selector;
+      forwarding_target_ptr target;
+    };
+
+    struct coalesced_method {
+      selector_t* selector;
+      std::unique_ptr<event_coalescer> coalescer;
+    };
+
+    /// State of a class, shared by the trampolines of the class and of its subclasses.
+    struct class_data {
+      inline explicit class_data(class_t* c) noexcept
+          : cls(c) {}
+
+      class_t* cls;
+
+      /// Set once an instance was observed (i.e. a NSKVONotifying_ subclass of the class may exist).
+      std::atomic<bool> observed = false;
+
+      /// Set when the class_descriptor of an observed class is destroyed, the slot of the class is cleared
+      /// along with its last instance.
+      std::atomic<bool> retired = false;
+
+      /// Live instances of the class and of its subclasses.
+      std::atomic<std::ptrdiff_t> live_instances = 0;
+
+      /// The dealloc defined with add_method(), if any.
+      imp_ptr dealloc = nullptr;
+
+      /// Methods added with add_lazy_method(), sorted by name in register_class().
+      std::vector<lazy_method> lazy_methods;
+
+      /// Coalescers of the methods added with add_coalesced_notification_method() and
+      /// add_coalesced_observer_method(), immutable once the class is registered.
+      std::vector<coalesced_method> coalesced_methods;
+
+      /// Forwarded selectors sorted by address, immutable once the class is registered.
+      std::vector<forwarding_entry> forwarding_entries;
+      forwarding_target_ptr default_forwarding_target = nullptr;
+      bool has_forwarding_methods = false;
+
+      /// Hidden class implementing the handlers of add_forwarding_handler(), and its only instance.
+      class_t* forwarder_class = nullptr;
+      obj_t* forwarder = nullptr;
+    };
+
+    struct class_slot {
+      std::atomic<class_t*> cls = nullptr;
+      std::atomic<class_data*> data = nullptr;
+    };
+
+    /// Blocks are appended when all the slots are taken and never freed, lookups don't lock.
+    struct class_block {
+      static constexpr std::size_t size = 16;
+
+      class_slot slots[size];
+      std::atomic<class_block*> next = nullptr;
+    };
+
     class_t* m_classObject;
+    std::unique_ptr<class_data> m_data;
+
+    /// Registered classes of this Descriptor, a slot is cleared when its class_descriptor is destroyed
+    /// (or with the last instance of an observed class) and reused by the next registered class.
+    static inline class_block s_classes = {};
+
+    /// Returns the slot of c, nullptr if c isn't a registered class of this Descriptor.
+    static inline class_slot* find_slot(class_t* c) noexcept;
+
+    /// Publishes data in a free slot, appending a block when all the slots are taken.
+    static void claim_slot(class_data* data);
+
+    /// Clears the slot holding data, if any.
+    static void clear_slot(class_data* data) noexcept;
+
+    /// Returns the data of c or of its closest superclass registered by this Descriptor,
+    /// e.g. for instances of a subclass or isa-swizzled by key-value observing.
+    static inline class_data* find_class_data(class_t* c) noexcept;
+
+    /// Returns the coalescer of the method sel of c (or of its closest registered superclass).
+    static inline event_coalescer* find_coalescer(class_t* c, selector_t* sel) noexcept;
+
+    /// Installs a method added with add_lazy_method() on the class of data.
+    static bool resolve_lazy_method(const class_data& data, selector_t* sel);
+
+    /// Receiver of the message being forwarded to the forwarder on this thread.
+    static inline thread_local obj_t* s_forwarding_receiver = nullptr;
+
+    static inline const forwarding_entry* find_forwarding_entry(const class_data& data, selector_t* sel) noexcept;
+
+    static obj_t* get_forwarder(obj_t* obj);
+
+    bool add_forwarding_methods();
 
     template <auto FunctionType, typename ReturnType, typename... Args>
-    inline bool add_member_method_impl(
-        ReturnType (Descriptor::*)(Args...), selector_t* selector, const char* signature);
+    static inline imp_ptr get_forwarding_handler_imp(ReturnType (Descriptor::*)(Args...));
+
+    template <auto FunctionType, typename ReturnType, typename... Args>
+    static inline imp_ptr get_forwarding_handler_imp(ReturnType (*)(obj_t*, selector_t*, Args...));
+
+    template <auto FunctionType, typename ReturnType, typename... Args>
+    static inline imp_ptr make_forwarding_handler_imp();
+
+    template <auto FunctionType>
+    static inline imp_ptr get_method_imp();
+
+    template <auto FunctionType, typename ReturnType, typename... Args>
+    static inline imp_ptr get_member_method_imp(ReturnType (Descriptor::*)(Args...));
+
+    template <auto FunctionType, typename ReturnType, typename... Args>
+    static inline imp_ptr get_member_method_imp(ReturnType (Descriptor::*)(Args...) const);
+
+    template <typename>
+    friend class descriptor_ref;
+  };
+
+
+  /// Typed handle to an instance of a class_descriptor<Descriptor> class.
+  ///
+  /// When the object is an instance of a registered class of the Descriptor, members are called directly on the
+  /// Descriptor instead of sending a message (objc::call -> imp lookup -> trampoline -> ivar lookup).
+  /// The class of the object is checked again on each call, the message is sent as soon as it changed
+  /// (e.g. isa-swizzled by key-value observing) and for instances of a subclass.
+  ///
+  /// @remarks The object is not retained and its Descriptor pointer must be set before creating the handle.
+  ///          The selector must be the one MemberFunctionPointer was added with, this is asserted in debug builds.
+  ///          Methods replaced directly with the objc runtime on the class itself are not detected in release builds.
+  template <typename Descriptor>
+  class descriptor_ref {
+  public:
+    descriptor_ref() noexcept = default;
+
+    explicit descriptor_ref(obj_t* obj);
+
+    inline obj_t* get() const noexcept { return m_obj; }
+
+    /// The Descriptor when members are called directly, nullptr otherwise.
+    inline Descriptor* get_descriptor() const noexcept { return m_descriptor; }
+
+    /// True when members are called directly, i.e. the object still has the class it had on construction.
+    inline bool is_direct() const noexcept { return m_descriptor && get_obj_class(m_obj) == m_class; }
+
+    /// Calls MemberFunctionPointer directly, or sends the selector it was added with.
+    template <auto MemberFunctionPointer, typename SelectorType, typename... Params>
+    inline decltype(auto) call(SelectorType selector, Params&&... params) const;
+
+  private:
+    obj_t* m_obj = nullptr;
+    class_t* m_class = nullptr;
+    Descriptor* m_descriptor = nullptr;
+
+    template <auto MemberFunctionPointer, typename SelectorType>
+    inline bool is_direct_call(SelectorType selector) const noexcept;
+
+    template <auto MemberFunctionPointer, typename ReturnType, typename... Args, typename SelectorType,
+        typename... Params>
+    inline ReturnType call_impl(ReturnType (Descriptor::*)(Args...), SelectorType selector, Params&&... params) const;
+
+    template <auto MemberFunctionPointer, typename ReturnType, typename... Args, typename SelectorType,
+        typename... Params>
+    inline ReturnType call_impl(
+        ReturnType (Descriptor::*)(Args...) const, SelectorType selector, Params&&... params) const;
   };
 
 } // namespace objc.
@@ -336,6 +773,17 @@ namespace objc {
   template <>
   inline void return_default_value<void>() {}
 
+  /// Struct returned in memory on architectures using objc_msgSend_stret.
+  template <typename T>
+  constexpr bool is_stret_type = []() {
+    if constexpr (std::is_class_v<T>) {
+      return sizeof(T) > 16;
+    }
+    else {
+      return false;
+    }
+  }();
+
   template <typename T, typename... Ts, std::enable_if_t<is_basic_type<T>, std::nullptr_t>>
   inline std::string get_encoding() {
     if constexpr (sizeof...(Ts) > 0) {
@@ -456,6 +904,12 @@ namespace objc {
     return "{" + std::string(name_for_type<T>::value) + "=" + get_encoding<Ts...>() + "}";
   }
 
+  template <typename R, typename... Args>
+  block_literal<R, Args...> make_block(typename block_literal<R, Args...>::invoke_ptr invoke, void* context) {
+    static constexpr block_descriptor descriptor = { 0, sizeof(block_literal<R, Args...>) };
+    return { get_stack_block_isa(), 0, 0, invoke, &descriptor, context };
+  }
+
   template <typename T>
   bool add_class_variable(class_t* c, const char* name, const char* encoding) {
     return add_class_variable(c, name, encoding, sizeof(T), alignof(T));
@@ -608,18 +1062,107 @@ namespace objc {
 
   std::string generate_random_alphanum_string(std::size_t length);
 
+  /// Lock-free cache of superclass implementations keyed by selector.
+  /// When full, find() keeps missing and the implementation is resolved on every call.
+  class super_imp_cache {
+  public:
+    static constexpr std::size_t max_size = 16;
+
+    inline imp_ptr find(selector_t* sel) const noexcept {
+      const std::size_t count = std::min(m_count.load(std::memory_order_acquire), max_size);
+      for (std::size_t i = 0; i < count; i++) {
+        if (m_entries[i].sel.load(std::memory_order_acquire) == sel) {
+          return m_entries[i].imp;
+        }
+      }
+
+      return nullptr;
+    }
+
+    inline void insert(selector_t* sel, imp_ptr imp) noexcept {
+      const std::size_t index = m_count.fetch_add(1, std::memory_order_acq_rel);
+      if (index >= max_size) {
+        m_count.store(max_size, std::memory_order_release);
+        return;
+      }
+
+      m_entries[index].imp = imp;
+      m_entries[index].sel.store(sel, std::memory_order_release);
+    }
+
+  private:
+    struct entry {
+      std::atomic<selector_t*> sel = nullptr;
+      imp_ptr imp = nullptr;
+    };
+
+    entry m_entries[max_size];
+    std::atomic<std::size_t> m_count = 0;
+  };
+
+  /// Lock-free cache of selectors keyed by the address of their name.
+  /// The name of the selector is compared on each hit, since names can be stored in reused buffers.
+  /// When full, or for a reused buffer, the selector is registered on every call.
+  class selector_name_cache {
+  public:
+    static constexpr std::size_t max_size = 16;
+
+    inline selector_t* get(const char* name) noexcept {
+      const std::size_t count = std::min(m_count.load(std::memory_order_acquire), max_size);
+      for (std::size_t i = 0; i < count; i++) {
+        if (m_entries[i].name.load(std::memory_order_acquire) == name) {
+          selector_t* sel = m_entries[i].sel;
+          return std::strcmp(get_selector_name(sel), name) == 0 ? sel : get_selector(name);
+        }
+      }
+
+      selector_t* sel = get_selector(name);
+      const std::size_t index = m_count.fetch_add(1, std::memory_order_acq_rel);
+      if (index >= max_size) {
+        m_count.store(max_size, std::memory_order_release);
+        return sel;
+      }
+
+      m_entries[index].sel = sel;
+      m_entries[index].name.store(name, std::memory_order_release);
+      return sel;
+    }
+
+  private:
+    struct entry {
+      std::atomic<const char*> name = nullptr;
+      selector_t* sel = nullptr;
+    };
+
+    entry m_entries[max_size];
+    std::atomic<std::size_t> m_count = 0;
+  };
+
   NANO_CLANG_PUSH_WARNING("-Wold-style-cast")
 
   template <typename Descriptor>
   class_descriptor<Descriptor>::class_descriptor(const char* rootName)
       : m_classObject(
-          allocate_class(get_class(Descriptor::baseName), (rootName + generate_random_alphanum_string(10)).c_str())) {
+          allocate_class(get_class(Descriptor::baseName), (rootName + generate_random_alphanum_string(10)).c_str()))
+      , m_data(std::make_unique<class_data>(m_classObject)) {
 
     if (!add_pointer<Descriptor>(Descriptor::valueName, Descriptor::className)) {
       std::cout << "ERROR" << std::endl;
       return;
     }
 
+    // Key-value observing isa-swizzles the instance to a NSKVONotifying_ subclass of this class,
+    // which can then no longer be disposed. Every observation path sets the observation info of the instance.
+    add_class_method(m_classObject, get_selector("setObservationInfo:"),
+        (imp_ptr)(method_ptr<void, void*>)[](obj_t * obj, selector_t * sel, void* info) {
+          if (class_data* data = info ? find_class_data(get_obj_class(obj)) : nullptr) {
+            data->observed.store(true, std::memory_order_relaxed);
+          }
+
+          send_superclass_message<void, void*>(obj, sel, info);
+        },
+        "v@:^v");
+
     /**
      * Creates a new class and metaclass.
      *
@@ -648,19 +1191,251 @@ namespace objc {
 
   template <typename Descriptor>
   class_descriptor<Descriptor>::~class_descriptor() {
-    std::string kvoSubclassName = std::string("NSKVONotifying_") + get_class_name(m_classObject);
+    // The class outlives its NSKVONotifying_ subclass, its data is kept for the instances left
+    // and its slot is cleared by the dealloc of the last one.
+    if (m_data->observed.load(std::memory_order_relaxed)) {
+      class_data* data = m_data.release();
+      data->retired.store(true);
+
+      if (data->live_instances.load() == 0) {
+        clear_slot(data);
+        set_class_instance_counter(data->cls, nullptr);
+      }
+
+      return;
+    }
+
+    // Pending events retain their receiver, dropped while the class can still dealloc them.
+    m_data->coalesced_methods.clear();
+
+    clear_slot(m_data.get());
+    dispose_class(m_classObject);
 
-    if (get_class(kvoSubclassName.c_str()) == nullptr) {
-      dispose_class(m_classObject);
+    if (m_data->forwarder) {
+      release(m_data->forwarder);
+    }
+
+    if (m_data->forwarder_class) {
+      dispose_class(m_data->forwarder_class);
     }
   }
 
   template <typename Descriptor>
   bool class_descriptor<Descriptor>::register_class() {
+    // Read-only once the class is published.
+    std::sort(m_data->lazy_methods.begin(), m_data->lazy_methods.end(),
+        [](const lazy_method& a, const lazy_method& b) { return std::strcmp(a.name, b.name) < 0; });
+
+    // Published before the class is registered, no instance can reach the trampolines before.
+    claim_slot(m_data.get());
+
+    set_class_instance_counter(m_classObject, &m_data->live_instances);
+
+    // Instances created with +alloc.
+    add_class_method(get_obj_class(reinterpret_cast<obj_t*>(m_classObject)), get_selector("allocWithZone:"),
+        (imp_ptr)(class_method_ptr<obj_t*, void*>)[](class_t * c, selector_t * sel, void* zone) {
+          static imp_ptr superAlloc = get_class_method_implementation(get_meta_class(Descriptor::baseName), sel);
+
+          if (class_data* data = find_class_data(c)) {
+            data->live_instances.fetch_add(1, std::memory_order_relaxed);
+          }
+
+          return reinterpret_cast<class_method_ptr<obj_t*, void*>>(superAlloc)(c, sel, zone);
+        },
+        "@@:^v");
+
+    m_data->dealloc = replace_class_method(m_classObject, get_selector("dealloc"),
+        (imp_ptr)(method_ptr<void>)[](obj_t * obj, selector_t * sel) {
+          class_data* data = find_class_data(get_obj_class(obj));
+          const bool last = data && data->live_instances.fetch_sub(1) == 1;
+
+          if (data && data->dealloc) {
+            reinterpret_cast<method_ptr<void>>(data->dealloc)(obj, sel);
+          }
+          else {
+            send_superclass_message<void>(obj, sel);
+          }
+
+          if (last && data->retired.load()) {
+            clear_slot(data);
+            set_class_instance_counter(data->cls, nullptr);
+          }
+        },
+        "v@:");
+
+    if (!m_data->lazy_methods.empty()) {
+      // c is this class, a subclass or a NSKVONotifying_ subclass.
+      add_class_method(get_obj_class(reinterpret_cast<obj_t*>(m_classObject)), get_selector("resolveInstanceMethod:"),
+          (imp_ptr)(class_method_ptr<bool, selector_t*>)[](class_t * c, selector_t * sel, selector_t * name) {
+            static imp_ptr superResolve = get_class_method_implementation(get_meta_class(Descriptor::baseName), sel);
+            const class_data* data = find_class_data(c);
+
+            return (data && resolve_lazy_method(*data, name))
+                || reinterpret_cast<class_method_ptr<bool, selector_t*>>(superResolve)(c, sel, name);
+          },
+          "B@::");
+    }
+
+    if (m_data->forwarder_class) {
+      objc::register_class(m_data->forwarder_class);
+      m_data->forwarder = create_class_instance(m_data->forwarder_class);
+    }
+
     objc::register_class(m_classObject);
     return true;
   }
 
+  template <typename Descriptor>
+  bool class_descriptor<Descriptor>::is_descriptor_class(class_t* c) noexcept {
+    return find_slot(c) != nullptr;
+  }
+
+  template <typename Descriptor>
+  typename class_descriptor<Descriptor>::class_slot* class_descriptor<Descriptor>::find_slot(class_t* c) noexcept {
+    if (!c) {
+      return nullptr;
+    }
+
+    for (class_block* block = &s_classes; block; block = block->next.load(std::memory_order_acquire)) {
+      for (class_slot& slot : block->slots) {
+        if (slot.cls.load(std::memory_order_acquire) == c) {
+          return &slot;
+        }
+      }
+    }
+
+    return nullptr;
+  }
+
+  template <typename Descriptor>
+  void class_descriptor<Descriptor>::claim_slot(class_data* data) {
+    for (class_block* block = &s_classes;;) {
+      for (class_slot& slot : block->slots) {
+        class_t* expected = nullptr;
+        if (slot.cls.compare_exchange_strong(expected, data->cls, std::memory_order_acq_rel)) {
+          slot.data.store(data, std::memory_order_release);
+          return;
+        }
+      }
+
+      class_block* next = block->next.load(std::memory_order_acquire);
+
+      if (!next) {
+        auto* appended = new class_block();
+        if (block->next.compare_exchange_strong(next, appended, std::memory_order_acq_rel)) {
+          next = appended;
+        }
+        else {
+          delete appended;
+        }
+      }
+
+      block = next;
+    }
+  }
+
+  template <typename Descriptor>
+  void class_descriptor<Descriptor>::clear_slot(class_data* data) noexcept {
+    for (class_block* block = &s_classes; block; block = block->next.load(std::memory_order_acquire)) {
+      for (class_slot& slot : block->slots) {
+        class_data* expected = data;
+        if (slot.data.compare_exchange_strong(expected, nullptr, std::memory_order_acq_rel)) {
+          slot.cls.store(nullptr, std::memory_order_release);
+          return;
+        }
+      }
+    }
+  }
+
+  template <typename Descriptor>
+  typename class_descriptor<Descriptor>::class_data* class_descriptor<Descriptor>::find_class_data(
+      class_t* c) noexcept {
+    for (; c; c = get_superclass(c)) {
+      if (class_slot* slot = find_slot(c)) {
+        return slot->data.load(std::memory_order_acquire);
+      }
+    }
+
+    return nullptr;
+  }
+
+  template <typename Descriptor>
+  event_coalescer* class_descriptor<Descriptor>::find_coalescer(class_t* c, selector_t* sel) noexcept {
+    if (class_data* data = find_class_data(c)) {
+      for (const coalesced_method& m : data->coalesced_methods) {
+        if (m.selector == sel) {
+          return m.coalescer.get();
+        }
+      }
+    }
+
+    return nullptr;
+  }
+
+  template <typename Descriptor>
+  descriptor_ref<Descriptor>::descriptor_ref(obj_t* obj)
+      : m_obj(obj) {
+    if (obj && class_descriptor<Descriptor>::is_descriptor_class(get_obj_class(obj))) {
+      m_class = get_obj_class(obj);
+      m_descriptor = objc::get_ivar_pointer<Descriptor*>(obj, Descriptor::valueName);
+    }
+  }
+
+  template <typename Descriptor>
+  template <auto MemberFunctionPointer, typename SelectorType>
+  bool descriptor_ref<Descriptor>::is_direct_call([[maybe_unused]] SelectorType selector) const noexcept {
+    if (!is_direct()) {
+      return false;
+    }
+
+  #ifndef NDEBUG
+    selector_t* sel = [](SelectorType s) {
+      if constexpr (std::is_same_v<SelectorType, selector_t*>) {
+        return s;
+      }
+      else {
+        return get_selector(s);
+      }
+    }(selector);
+
+    // The message would not reach MemberFunctionPointer (wrong selector or replaced method).
+    assert(get_class_method_implementation(m_class, sel)
+        == class_descriptor<Descriptor>::template get_method_imp<MemberFunctionPointer>());
+  #endif // NDEBUG
+
+    return true;
+  }
+
+  template <typename Descriptor>
+  template <auto MemberFunctionPointer, typename SelectorType, typename... Params>
+  decltype(auto) descriptor_ref<Descriptor>::call(SelectorType selector, Params&&... params) const {
+    return call_impl<MemberFunctionPointer>(MemberFunctionPointer, selector, std::forward<Params>(params)...);
+  }
+
+  template <typename Descriptor>
+  template <auto MemberFunctionPointer, typename ReturnType, typename... Args, typename SelectorType,
+      typename... Params>
+  ReturnType descriptor_ref<Descriptor>::call_impl(
+      ReturnType (Descriptor::*)(Args...), SelectorType selector, Params&&... params) const {
+    if (is_direct_call<MemberFunctionPointer>(selector)) {
+      return (m_descriptor->*MemberFunctionPointer)(std::forward<Params>(params)...);
+    }
+
+    return objc::call<ReturnType, Args...>(m_obj, selector, std::forward<Params>(params)...);
+  }
+
+  template <typename Descriptor>
+  template <auto MemberFunctionPointer, typename ReturnType, typename... Args, typename SelectorType,
+      typename... Params>
+  ReturnType descriptor_ref<Descriptor>::call_impl(
+      ReturnType (Descriptor::*)(Args...) const, SelectorType selector, Params&&... params) const {
+    if (is_direct_call<MemberFunctionPointer>(selector)) {
+      return (m_descriptor->*MemberFunctionPointer)(std::forward<Params>(params)...);
+    }
+
+    return objc::call<ReturnType, Args...>(m_obj, selector, std::forward<Params>(params)...);
+  }
+
   template <typename Descriptor>
   obj_t* class_descriptor<Descriptor>::create_instance() const {
     return create_class_instance(m_classObject);
@@ -669,18 +1444,40 @@ namespace objc {
   template <typename Descriptor>
   template <typename ReturnType, typename... Args, typename... Params>
   ReturnType class_descriptor<Descriptor>::send_superclass_message(
-      obj_t* obj, const char* selectorName, Params&&... params) {
+      obj_t* obj, selector_t* sel, Params&&... params) {
+
+    static class_t* superClass = get_class(Descriptor::baseName);
+    static super_imp_cache cache;
+
+    if (!superClass) {
+      //    assert(false"Could not create objc class");
+      return return_default_value<ReturnType>();
+    }
+
+    imp_ptr imp = cache.find(sel);
 
-    if (class_t* objClass = get_class(Descriptor::baseName)) {
-      using FctType = super_method_ptr<ReturnType, Args...>;
+    if (!imp) {
+      if constexpr (is_stret_type<ReturnType>) {
+        imp = get_class_method_implementation_stret(superClass, sel);
+      }
+      else {
+        imp = get_class_method_implementation(superClass, sel);
+      }
 
-      std::pair<obj_t*, class_t*> s = { obj, objClass };
-      return reinterpret_cast<FctType>(send_super_fct)(
-          (super_t*)&s, get_selector(selectorName), std::forward<Params>(params)...);
+      cache.insert(sel, imp);
     }
 
-    //    assert(false"Could not create objc class");
-    return return_default_value<ReturnType>();
+    // Calling the imp directly, the return value is handled by the compiler (no stret or fpret needed).
+    return reinterpret_cast<method_ptr<ReturnType, Args...>>(imp)(obj, sel, std::forward<Params>(params)...);
+  }
+
+  template <typename Descriptor>
+  template <typename ReturnType, typename... Args, typename... Params>
+  inline ReturnType class_descriptor<Descriptor>::send_superclass_message(
+      obj_t* obj, const char* selectorName, Params&&... params) {
+    static selector_name_cache names;
+    return send_superclass_message<ReturnType, Args...>(
+        obj, names.get(selectorName), std::forward<Params>(params)...);
   }
 
   template <typename Descriptor>
@@ -692,14 +1489,29 @@ namespace objc {
   template <typename Descriptor>
   template <auto FunctionType>
   inline bool class_descriptor<Descriptor>::add_method(const char* selectorName, const char* signature) {
-    selector_t* selector = get_selector(selectorName);
+    return add_class_method(m_classObject, get_selector(selectorName), get_method_imp<FunctionType>(), signature);
+  }
 
-    if constexpr (std::is_member_function_pointer_v<decltype(FunctionType)>) {
-      return add_member_method_impl<FunctionType>(FunctionType, selector, signature);
-    }
-    else {
-      return add_class_method(m_classObject, selector, (imp_ptr)FunctionType, signature);
+  template <typename Descriptor>
+  template <auto FunctionType>
+  inline void class_descriptor<Descriptor>::add_lazy_method(const char* selectorName, const char* signature) {
+    m_data->lazy_methods.push_back({ selectorName, get_method_imp<FunctionType>(), signature });
+  }
+
+  template <typename Descriptor>
+  bool class_descriptor<Descriptor>::resolve_lazy_method(const class_data& data, selector_t* sel) {
+    const char* name = get_selector_name(sel);
+    auto it = std::lower_bound(data.lazy_methods.begin(), data.lazy_methods.end(), name,
+        [](const lazy_method& m, const char* n) { return std::strcmp(m.name, n) < 0; });
+
+    if (it == data.lazy_methods.end() || std::strcmp(it->name, name) != 0) {
+      return false;
     }
+
+    // Installed on the descriptor class, subclasses inherit it.
+    // Fails when another thread resolved it first, the method exists either way.
+    add_class_method(data.cls, sel, it->imp, it->signature);
+    return true;
   }
 
   template <typename Descriptor>
@@ -715,6 +1527,220 @@ namespace objc {
         "v@:@");
   }
 
+  template <typename Descriptor>
+  template <void (Descriptor::*MemberFunctionPointer)(obj_t*, std::size_t)>
+  bool class_descriptor<Descriptor>::add_coalesced_notification_method(const char* selectorName, double window) {
+    selector_t* sel = get_selector(selectorName);
+
+    const bool added = add_class_method(m_classObject, sel,
+        (imp_ptr)(method_ptr<void, obj_t*>)[](obj_t * obj, selector_t * cmd, obj_t * notification) {
+          static selector_t* nameSelector = get_selector("name");
+          static selector_t* objectSelector = get_selector("object");
+
+          if (event_coalescer* coalescer = find_coalescer(get_obj_class(obj), cmd)) {
+            coalescer->post(obj, call<obj_t*>(notification, nameSelector), call<obj_t*>(notification, objectSelector),
+                notification);
+          }
+        },
+        "v@:@");
+
+    if (added) {
+      m_data->coalesced_methods.push_back({ sel,
+          std::make_unique<event_coalescer>(
+              [](obj_t* obj, obj_t*, obj_t*, obj_t* notification, std::size_t count) {
+                if (auto* p = objc::get_ivar_pointer<Descriptor*>(obj, Descriptor::valueName)) {
+                  (p->*MemberFunctionPointer)(notification, count);
+                }
+              },
+              window) });
+    }
+
+    return added;
+  }
+
+  template <typename Descriptor>
+  template <void (Descriptor::*MemberFunctionPointer)(obj_t*, obj_t*, obj_t*, std::size_t)>
+  bool class_descriptor<Descriptor>::add_coalesced_observer_method(double window) {
+    selector_t* sel = get_selector("observeValueForKeyPath:ofObject:change:context:");
+
+    const bool added = add_class_method(m_classObject, sel,
+        (imp_ptr)(method_ptr<void, obj_t*, obj_t*, obj_t*, void*>)[](
+            obj_t * obj, selector_t * cmd, obj_t * keyPath, obj_t * object, obj_t * change, void*) {
+          if (event_coalescer* coalescer = find_coalescer(get_obj_class(obj), cmd)) {
+            coalescer->post(obj, keyPath, object, change);
+          }
+        },
+        "v@:@@@^v");
+
+    if (added) {
+      m_data->coalesced_methods.push_back({ sel,
+          std::make_unique<event_coalescer>(
+              [](obj_t* obj, obj_t* keyPath, obj_t* object, obj_t* change, std::size_t count) {
+                if (auto* p = objc::get_ivar_pointer<Descriptor*>(obj, Descriptor::valueName)) {
+                  (p->*MemberFunctionPointer)(keyPath, object, change, count);
+                }
+              },
+              window) });
+    }
+
+    return added;
+  }
+
+  template <typename Descriptor>
+  template <auto TargetFunction>
+  bool class_descriptor<Descriptor>::add_forwarding_target(std::initializer_list<const char*> selectorNames) {
+    forwarding_target_ptr target = [](obj_t* obj) -> obj_t* {
+      if constexpr (std::is_member_function_pointer_v<decltype(TargetFunction)>) {
+        auto* p = objc::get_ivar_pointer<Descriptor*>(obj, Descriptor::valueName);
+        return p ? (p->*TargetFunction)() : nullptr;
+      }
+      else {
+        return TargetFunction(obj);
+      }
+    };
+
+    if (!add_forwarding_methods()) {
+      return false;
+    }
+
+    if (selectorNames.size() == 0) {
+      m_data->default_forwarding_target = target;
+      return true;
+    }
+
+    std::vector<forwarding_entry>& entries = m_data->forwarding_entries;
+
+    for (const char* name : selectorNames) {
+      selector_t* sel = get_selector(name);
+      auto it = std::lower_bound(entries.begin(), entries.end(), sel,
+          [](const forwarding_entry& e, selector_t* s) { return e.selector < s; });
+
+      if (it != entries.end() && it->selector == sel) {
+        it->target = target;
+      }
+      else {
+        entries.insert(it, { sel, target });
+      }
+    }
+
+    return true;
+  }
+
+  template <typename Descriptor>
+  template <auto FunctionType>
+  bool class_descriptor<Descriptor>::add_forwarding_handler(const char* selectorName, const char* signature) {
+    if (!m_data->forwarder_class) {
+      m_data->forwarder_class
+          = allocate_class(get_class("NSObject"), (std::string(get_class_name(m_classObject)) + "_forwarder").c_str());
+
+      if (!m_data->forwarder_class) {
+        return false;
+      }
+    }
+
+    return add_class_method(m_data->forwarder_class, get_selector(selectorName),
+               get_forwarding_handler_imp<FunctionType>(FunctionType), signature)
+        && add_forwarding_target<&class_descriptor::get_forwarder>({ selectorName });
+  }
+
+  template <typename Descriptor>
+  obj_t* class_descriptor<Descriptor>::get_forwarder(obj_t* obj) {
+    class_data* data = find_class_data(get_obj_class(obj));
+    if (!data || !data->forwarder) {
+      return nullptr;
+    }
+
+    // The runtime resends the message to the forwarder right after forwardingTargetForSelector: returns.
+    s_forwarding_receiver = obj;
+    return data->forwarder;
+  }
+
+  template <typename Descriptor>
+  template <auto FunctionType, typename ReturnType, typename... Args>
+  inline imp_ptr class_descriptor<Descriptor>::get_forwarding_handler_imp(ReturnType (Descriptor::*)(Args...)) {
+    return make_forwarding_handler_imp<FunctionType, ReturnType, Args...>();
+  }
+
+  template <typename Descriptor>
+  template <auto FunctionType, typename ReturnType, typename... Args>
+  inline imp_ptr class_descriptor<Descriptor>::get_forwarding_handler_imp(
+      ReturnType (*)(obj_t*, selector_t*, Args...)) {
+    return make_forwarding_handler_imp<FunctionType, ReturnType, Args...>();
+  }
+
+  template <typename Descriptor>
+  template <auto FunctionType, typename ReturnType, typename... Args>
+  inline imp_ptr class_descriptor<Descriptor>::make_forwarding_handler_imp() {
+    return (imp_ptr)(method_ptr<ReturnType, Args...>)[](obj_t*, selector_t * sel, Args... args)->ReturnType {
+      obj_t* receiver = std::exchange(s_forwarding_receiver, nullptr);
+      if (!receiver) {
+        return return_default_value<ReturnType>();
+      }
+
+      return reinterpret_cast<method_ptr<ReturnType, Args...>>(get_method_imp<FunctionType>())(receiver, sel, args...);
+    };
+  }
+
+  template <typename Descriptor>
+  inline const typename class_descriptor<Descriptor>::forwarding_entry*
+  class_descriptor<Descriptor>::find_forwarding_entry(const class_data& data, selector_t* sel) noexcept {
+    auto it = std::lower_bound(data.forwarding_entries.begin(), data.forwarding_entries.end(), sel,
+        [](const forwarding_entry& e, selector_t* s) { return e.selector < s; });
+
+    return it != data.forwarding_entries.end() && it->selector == sel ? &*it : nullptr;
+  }
+
+  template <typename Descriptor>
+  bool class_descriptor<Descriptor>::add_forwarding_methods() {
+    if (m_data->has_forwarding_methods) {
+      return true;
+    }
+
+    bool added = add_class_method(m_classObject, get_selector("forwardingTargetForSelector:"),
+        (imp_ptr)(method_ptr<obj_t*, selector_t*>)[](obj_t * obj, selector_t*, selector_t * sel)->obj_t* {
+          const class_data* data = find_class_data(get_obj_class(obj));
+          if (!data) {
+            return nullptr;
+          }
+
+          const forwarding_entry* entry = find_forwarding_entry(*data, sel);
+          forwarding_target_ptr target = entry ? entry->target : data->default_forwarding_target;
+          obj_t* t = target ? target(obj) : nullptr;
+
+          // Returning self would loop forever.
+          return t == obj ? nullptr : t;
+        },
+        "@@::");
+
+    // Only the explicitly forwarded selectors are reported, the default target may not respond to everything.
+    added = added
+        && add_class_method(m_classObject, get_selector("respondsToSelector:"),
+            (imp_ptr)(method_ptr<bool, selector_t*>)[](obj_t * obj, selector_t * cmd, selector_t * sel) {
+              // The base class may override respondsToSelector: as well.
+              if (send_superclass_message<bool, selector_t*>(obj, cmd, sel)) {
+                return true;
+              }
+
+              const class_data* data = find_class_data(get_obj_class(obj));
+              const forwarding_entry* entry = data ? find_forwarding_entry(*data, sel) : nullptr;
+
+              if (!entry) {
+                return false;
+              }
+
+              obj_t* t = entry->target(obj);
+
+              // No message is resent to the forwarder.
+              s_forwarding_receiver = nullptr;
+
+              return t && t != obj && call<bool>(t, cmd, sel);
+            },
+            "B@::");
+
+    m_data->has_forwarding_methods = added;
+    return added;
+  }
+
   template <typename Descriptor>
   inline bool class_descriptor<Descriptor>::add_protocol(const char* protocolName, bool force) {
 
@@ -735,17 +1761,33 @@ namespace objc {
     return false;
   }
 
+  template <typename Descriptor>
+  template <auto FunctionType>
+  inline imp_ptr class_descriptor<Descriptor>::get_method_imp() {
+    if constexpr (std::is_member_function_pointer_v<decltype(FunctionType)>) {
+      return get_member_method_imp<FunctionType>(FunctionType);
+    }
+    else {
+      return (imp_ptr)FunctionType;
+    }
+  }
+
   template <typename Descriptor>
   template <auto FunctionType, typename ReturnType, typename... Args>
-  inline bool class_descriptor<Descriptor>::add_member_method_impl(
-      ReturnType (Descriptor::*)(Args...), selector_t* selector, const char* signature) {
-    return add_class_method(
-        m_classObject, selector,
-        (imp_ptr)(method_ptr<ReturnType, Args...>)[](obj_t * obj, selector_t*, Args... args) {
-          auto* p = objc::get_ivar_pointer<Descriptor*>(obj, Descriptor::valueName);
-          return p ? (p->*FunctionType)(args...) : return_default_value<ReturnType>();
-        },
-        signature);
+  inline imp_ptr class_descriptor<Descriptor>::get_member_method_imp(ReturnType (Descriptor::*)(Args...)) {
+    return (imp_ptr)(method_ptr<ReturnType, Args...>)[](obj_t * obj, selector_t*, Args... args) {
+      auto* p = objc::get_ivar_pointer<Descriptor*>(obj, Descriptor::valueName);
+      return p ? (p->*FunctionType)(args...) : return_default_value<ReturnType>();
+    };
+  }
+
+  template <typename Descriptor>
+  template <auto FunctionType, typename ReturnType, typename... Args>
+  inline imp_ptr class_descriptor<Descriptor>::get_member_method_imp(ReturnType (Descriptor::*)(Args...) const) {
+    return (imp_ptr)(method_ptr<ReturnType, Args...>)[](obj_t * obj, selector_t*, Args... args) {
+      auto* p = objc::get_ivar_pointer<Descriptor*>(obj, Descriptor::valueName);
+      return p ? (p->*FunctionType)(args...) : return_default_value<ReturnType>();
+    };
   }
 
   NANO_CLANG_POP_WARNING()
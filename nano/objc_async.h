@@ -0,0 +1,187 @@
+/*
+ * Nano Library
+ *
+ * Copyright (C) 2026, Meta-Sonic
+ * All rights reserved.
+ *
+ * Proprietary and confidential.
+ * Any unauthorized copying, alteration, distribution, transmission, performance,
+ * display or other use of this material is strictly prohibited.
+ */
+
+#pragma once
+
+/*!
+ * @file      nano/objc_async.h
+ * @brief     nano objc coroutines
+ * @copyright Copyright (C) 2026, Meta-Sonic
+ * @date      Created 18/10/2026
+ *
+ * @remarks This header requires C++20 (see the nano::objc-async target).
+ */
+
+#include <nano/objc.h>
+
+#if __cplusplus < 202002L
+  #error "nano/objc_async.h requires C++20"
+#endif
+
+#include <atomic>
+#include <concepts>
+#include <coroutine>
+#include <tuple>
+
+#ifdef __APPLE__
+
+NANO_CLANG_DIAGNOSTIC_PUSH()
+NANO_CLANG_DIAGNOSTIC(warning, "-Weverything")
+NANO_CLANG_DIAGNOSTIC(ignored, "-Wc++98-compat")
+
+namespace nano::objc {
+
+/// An executor resumes a suspended coroutine, usually on another thread.
+template <typename Executor>
+concept executor = requires(const Executor& e, std::coroutine_handle<> h) { e.post(h); };
+
+/// Resumes the coroutine on the thread calling the completion handler.
+struct inline_executor {
+  /// The awaiting coroutine continues without being posted when the completion handler is called synchronously.
+  static constexpr bool is_inline = true;
+
+  inline void post(std::coroutine_handle<> h) const { h.resume(); }
+};
+
+/// True for executors resuming coroutines on the calling thread,
+/// i.e. declaring `static constexpr bool is_inline = true`.
+template <typename Executor>
+constexpr bool is_inline_executor = requires { requires Executor::is_inline; };
+
+/// Resumes the coroutine on a dispatch queue.
+struct queue_executor {
+  void* queue;
+
+  inline void post(std::coroutine_handle<> h) const {
+    dispatch_on_queue(
+        queue, h.address(), [](void* address) { std::coroutine_handle<>::from_address(address).resume(); });
+  }
+};
+
+inline queue_executor main_queue_executor() { return { get_main_queue() }; }
+
+/// Value returned by co_await on an async_call.
+/// void for an empty completion handler, Results for a single argument and std::tuple<Results...> otherwise.
+template <typename... Results>
+using async_result_t = std::conditional_t<sizeof...(Results) == 0, void,
+    std::conditional_t<sizeof...(Results) == 1, std::tuple_element_t<0, std::tuple<Results..., void>>,
+        std::tuple<Results...>>>;
+
+/// Awaitable sending a message whose last argument is a completion handler.
+///
+/// The completion block and the message arguments live inside the awaitable (i.e. in the coroutine frame).
+/// The block is a stack block: a callee completing synchronously uses it in place, a callee completing
+/// asynchronously copies it to the heap (Block_copy), which is one allocation per co_await.
+/// It can't be made a global block, the callee may release its copy after the coroutine frame is destroyed.
+///
+/// @remarks obj_t* results are retained before the coroutine is resumed, since the receiver is free
+///          to release them as soon as the completion handler returns. The caller owns them.
+template <executor Executor, typename Send, typename... Results>
+class async_call_awaitable {
+public:
+  using block_type = block_literal<void, Results...>;
+  using result_type = async_result_t<Results...>;
+
+  inline async_call_awaitable(Executor executor, Send send)
+      : m_executor(executor)
+      , m_send(send) {}
+
+  async_call_awaitable(const async_call_awaitable&) = delete;
+  async_call_awaitable& operator=(const async_call_awaitable&) = delete;
+
+  inline bool await_ready() const noexcept { return false; }
+
+  /// @returns false to resume right away when the completion handler was called synchronously by an inline
+  ///          executor, resuming from here would grow the stack on every synchronous completion.
+  inline bool await_suspend(std::coroutine_handle<> h) {
+    m_handle = h;
+    m_block = make_block<void, Results...>(&completion, this);
+
+    m_send(m_block.get());
+
+    // The completion handler was called before the message returned.
+    if (m_completed.exchange(true, std::memory_order_acq_rel)) {
+      if constexpr (is_inline_executor<Executor>) {
+        return false;
+      }
+      else {
+        m_executor.post(h);
+      }
+    }
+
+    return true;
+  }
+
+  inline result_type await_resume() {
+    if constexpr (sizeof...(Results) == 1) {
+      return std::get<0>(m_results);
+    }
+    else if constexpr (sizeof...(Results) > 1) {
+      return m_results;
+    }
+  }
+
+private:
+  Executor m_executor;
+  Send m_send;
+  std::coroutine_handle<> m_handle;
+  block_type m_block;
+  std::tuple<Results...> m_results;
+  std::atomic<bool> m_completed = false;
+
+  template <typename T>
+  static inline T retain_result(T value) {
+    if constexpr (std::is_same_v<T, obj_t*>) {
+      if (value) {
+        retain(value);
+      }
+    }
+
+    return value;
+  }
+
+  static void completion(block_type* block, Results... results) {
+    auto* self = static_cast<async_call_awaitable*>(block->context);
+    self->m_results = std::tuple<Results...>(retain_result(results)...);
+
+    // The awaitable can be destroyed as soon as the coroutine is resumed.
+    Executor executor = self->m_executor;
+    std::coroutine_handle<> h = self->m_handle;
+
+    if (self->m_completed.exchange(true, std::memory_order_acq_rel)) {
+      executor.post(h);
+    }
+  }
+};
+
+/// Sends a message whose last argument is a completion handler taking Results...
+/// and resumes the awaiting coroutine on the given executor.
+///
+/// @code
+/// obj_t* data = co_await objc::async_call<obj_t*>(objc::main_queue_executor(), obj, "loadData:", url);
+/// @endcode
+template <typename... Results, executor Executor, typename SelectorType, typename... Params>
+inline auto async_call(Executor executor, obj_t* obj, SelectorType selector, Params... params) {
+  auto send = [=](obj_t* block) { call<void, null_to_obj<Params>..., obj_t*>(obj, selector, params..., block); };
+  return async_call_awaitable<Executor, decltype(send), Results...>(executor, send);
+}
+
+/// Sends a message whose last argument is a completion handler taking Results...
+/// and resumes the awaiting coroutine on the thread calling the completion handler.
+template <typename... Results, typename SelectorType, typename... Params>
+inline auto async_call(obj_t* obj, SelectorType selector, Params... params) {
+  return async_call<Results...>(inline_executor{}, obj, selector, params...);
+}
+} // namespace nano::objc.
+
+NANO_CLANG_DIAGNOSTIC_POP()
+
+#endif // __APPLE__
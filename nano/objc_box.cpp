@@ -0,0 +1,138 @@
+#include <nano/objc_box.h>
+
+#ifdef __APPLE__
+  #include <nano/objc_invoke.h>
+  #include <CoreFoundation/CoreFoundation.h>
+  #include <atomic>
+  #include <cstring>
+
+namespace nano::objc::detail {
+namespace {
+  constexpr long long min_cached_integer = -16;
+  constexpr long long max_cached_integer = 255;
+
+  /// Boxed small integers, created on first use and never released.
+  std::atomic<obj_t*> integer_cache[max_cached_integer - min_cached_integer + 1];
+
+  inline obj_t* to_obj(CFTypeRef ref) { return reinterpret_cast<obj_t*>(const_cast<void*>(ref)); }
+
+  inline CFTypeRef to_cf(obj_t* obj) { return static_cast<CFTypeRef>(obj); }
+
+  inline obj_t* create_integer(long long value) {
+    return to_obj(CFNumberCreate(kCFAllocatorDefault, kCFNumberSInt64Type, &value));
+  }
+
+  struct value_class {
+    class_t* cls = get_class("NSValue");
+    selector_t* alloc = get_selector("alloc");
+    selector_t* init = get_selector("initWithBytes:objCType:");
+    selector_t* is_kind = get_selector("isKindOfClass:");
+    selector_t* type = get_selector("objCType");
+    selector_t* get_value = get_selector("getValue:size:");
+
+    static const value_class& get() {
+      static const value_class c;
+      return c;
+    }
+  };
+} // namespace.
+
+obj_t* box_number(number_type type, const void* value) {
+  return to_obj(CFNumberCreate(kCFAllocatorDefault, static_cast<CFNumberType>(type), value));
+}
+
+obj_t* box_integer(long long value) {
+  if (value < min_cached_integer || value > max_cached_integer) {
+    return create_integer(value);
+  }
+
+  std::atomic<obj_t*>& slot = integer_cache[value - min_cached_integer];
+  obj_t* obj = slot.load(std::memory_order_acquire);
+
+  if (!obj) {
+    obj_t* created = create_integer(value);
+    if (slot.compare_exchange_strong(obj, created, std::memory_order_acq_rel)) {
+      obj = created;
+    }
+    else {
+      CFRelease(to_cf(created));
+    }
+  }
+
+  if (!is_tagged_pointer(obj)) {
+    CFRetain(to_cf(obj));
+  }
+
+  return obj;
+}
+
+obj_t* box_unsigned_integer(unsigned long long value) {
+  if (value <= static_cast<unsigned long long>(std::numeric_limits<long long>::max())) {
+    return box_integer(static_cast<long long>(value));
+  }
+
+  // CFNumber has no unsigned types, NSNumber keeps the value as a 128-bit integer.
+  return call<obj_t*>(call<obj_t*>(get_class("NSNumber"), "alloc"), "initWithUnsignedLongLong:", value);
+}
+
+obj_t* box_bool(bool value) { return to_obj(CFRetain(value ? kCFBooleanTrue : kCFBooleanFalse)); }
+
+obj_t* box_value(const void* value, const char* encoding) {
+  const value_class& c = value_class::get();
+  return call<obj_t*>(call<obj_t*>(c.cls, c.alloc), c.init, value, encoding);
+}
+
+bool unbox_number(obj_t* obj, number_type type, void* value) {
+  if (!obj) {
+    return false;
+  }
+
+  const CFTypeID id = CFGetTypeID(to_cf(obj));
+
+  if (id == CFNumberGetTypeID()) {
+    return CFNumberGetValue(static_cast<CFNumberRef>(to_cf(obj)), static_cast<CFNumberType>(type), value);
+  }
+
+  if (id == CFBooleanGetTypeID()) {
+    const std::int8_t b = CFBooleanGetValue(static_cast<CFBooleanRef>(to_cf(obj))) ? 1 : 0;
+    CFNumberRef number = CFNumberCreate(kCFAllocatorDefault, kCFNumberSInt8Type, &b);
+    const bool ok = CFNumberGetValue(number, static_cast<CFNumberType>(type), value);
+    CFRelease(number);
+    return ok;
+  }
+
+  return false;
+}
+
+bool unbox_unsigned_integer(obj_t* obj, unsigned long long& value) {
+  long long v = 0;
+  if (unbox_number(obj, number_type::sint64, &v)) {
+    value = static_cast<unsigned long long>(v);
+    return v >= 0;
+  }
+
+  if (!obj || CFGetTypeID(to_cf(obj)) != CFNumberGetTypeID()) {
+    return false;
+  }
+
+  // Doesn't fit in a signed 64-bit integer, only valid for numbers created from an unsigned long long.
+  value = call<unsigned long long>(obj, "unsignedLongLongValue");
+  return std::strcmp(call<const char*>(obj, "objCType"), "Q") == 0;
+}
+
+bool unbox_value(obj_t* obj, void* value, std::size_t size) {
+  const value_class& c = value_class::get();
+
+  if (!obj || CFGetTypeID(to_cf(obj)) == CFNumberGetTypeID() || !call<bool>(obj, c.is_kind, c.cls)) {
+    return false;
+  }
+
+  if (get_encoding_size(call<const char*>(obj, c.type)) != size) {
+    return false;
+  }
+
+  call(obj, c.get_value, value, static_cast<unsigned long>(size));
+  return true;
+}
+} // namespace nano::objc::detail.
+#endif // __APPLE__
@@ -0,0 +1,169 @@
+/*
+ * Nano Library
+ *
+ * Copyright (C) 2026, Meta-Sonic
+ * All rights reserved.
+ *
+ * Proprietary and confidential.
+ * Any unauthorized copying, alteration, distribution, transmission, performance,
+ * display or other use of this material is strictly prohibited.
+ */
+
+#pragma once
+
+/*!
+ * @file      nano/objc_box.h
+ * @brief     nano objc NSNumber and NSValue boxing
+ * @copyright Copyright (C) 2026, Meta-Sonic
+ * @date      Created 18/10/2026
+ */
+
+#include <nano/objc.h>
+
+#ifdef __APPLE__
+  #include <TargetConditionals.h>
+  #include <cstdint>
+  #include <limits>
+  #include <string>
+  #include <type_traits>
+
+NANO_CLANG_DIAGNOSTIC_PUSH()
+NANO_CLANG_DIAGNOSTIC(warning, "-Weverything")
+NANO_CLANG_DIAGNOSTIC(ignored, "-Wc++98-compat")
+
+namespace nano::objc {
+
+/// Returns true if obj is a tagged pointer (e.g. a small NSNumber), the object is encoded in the pointer itself:
+/// it was never allocated and retaining or releasing it does nothing.
+inline bool is_tagged_pointer(const obj_t* obj) noexcept {
+  #if defined(__x86_64__) && TARGET_OS_OSX
+  // 64-bit Mac, the tag bit is the least significant bit.
+  return (reinterpret_cast<std::uintptr_t>(obj) & 1) != 0;
+  #elif defined(__LP64__)
+  return (reinterpret_cast<std::uintptr_t>(obj) >> 63) != 0;
+  #else
+  return false;
+  #endif
+}
+
+/// Boxes an arithmetic value in a NSNumber (through CFNumberCreate), or a trivially copyable struct in a NSValue.
+///
+/// Integers are stored as 64-bit numbers and bools as kCFBooleanTrue or kCFBooleanFalse.
+/// Small integers come from a cache of constants and most other numbers are tagged pointers,
+/// in both cases nothing is allocated.
+///
+/// Structs are described by their Members (see get_encoding()), which requires a name_for_type<T> specialization.
+///
+/// @returns An owned object (i.e. release() it or wrap it in an obj_unique_ptr).
+template <typename T, typename... Members>
+inline obj_t* box(const T& value);
+
+/// Boxes a struct in a NSValue with an explicit type encoding.
+template <typename T>
+inline obj_t* box(const T& value, const char* encoding);
+
+/// Unboxes a NSNumber or a NSValue.
+///
+/// @returns false if obj is nil, if obj is not a NSNumber (arithmetic T) or a NSValue of the same size (struct T),
+///          or if the number doesn't fit in T (value is still set, truncated).
+template <typename T>
+inline bool unbox(obj_t* obj, T& value);
+
+/// Returns the unboxed value (truncated if it doesn't fit in T), or T{} if obj is not a NSNumber or NSValue of T.
+template <typename T>
+inline T unbox(obj_t* obj);
+
+//
+//
+//
+
+namespace detail {
+  /// Same values as CFNumberType.
+  enum class number_type : long { sint8 = 1, sint16 = 2, sint32 = 3, sint64 = 4, float32 = 5, float64 = 6 };
+
+  obj_t* box_number(number_type type, const void* value);
+  obj_t* box_integer(long long value);
+  obj_t* box_unsigned_integer(unsigned long long value);
+  obj_t* box_bool(bool value);
+  obj_t* box_value(const void* value, const char* encoding);
+
+  bool unbox_number(obj_t* obj, number_type type, void* value);
+  bool unbox_unsigned_integer(obj_t* obj, unsigned long long& value);
+  bool unbox_value(obj_t* obj, void* value, std::size_t size);
+} // namespace detail.
+
+template <typename T, typename... Members>
+obj_t* box(const T& value) {
+  if constexpr (std::is_same_v<T, bool>) {
+    return detail::box_bool(value);
+  }
+  else if constexpr (std::is_integral_v<T>) {
+    if constexpr (std::is_unsigned_v<T> && sizeof(T) >= sizeof(long long)) {
+      return detail::box_unsigned_integer(value);
+    }
+    else {
+      return detail::box_integer(static_cast<long long>(value));
+    }
+  }
+  else if constexpr (std::is_floating_point_v<T>) {
+    static_assert(sizeof(T) <= sizeof(double), "long double can't be boxed");
+    return detail::box_number(sizeof(T) == 4 ? detail::number_type::float32 : detail::number_type::float64, &value);
+  }
+  else {
+    static_assert(std::is_trivially_copyable_v<T>, "boxed structs must be trivially copyable");
+    static const std::string encoding = get_encoding<T, Members...>();
+    return detail::box_value(&value, encoding.c_str());
+  }
+}
+
+template <typename T>
+obj_t* box(const T& value, const char* encoding) {
+  static_assert(std::is_trivially_copyable_v<T>, "boxed structs must be trivially copyable");
+  return detail::box_value(&value, encoding);
+}
+
+template <typename T>
+bool unbox(obj_t* obj, T& value) {
+  if constexpr (std::is_same_v<T, bool>) {
+    signed char c = 0;
+    const bool ok = detail::unbox_number(obj, detail::number_type::sint8, &c);
+    value = c != 0;
+    return ok;
+  }
+  else if constexpr (std::is_integral_v<T>) {
+    if constexpr (std::is_unsigned_v<T> && sizeof(T) >= sizeof(long long)) {
+      unsigned long long v = 0;
+      const bool ok = detail::unbox_unsigned_integer(obj, v);
+      value = static_cast<T>(v);
+      return ok;
+    }
+    else {
+      long long v = 0;
+      const bool ok = detail::unbox_number(obj, detail::number_type::sint64, &v);
+      value = static_cast<T>(v);
+      return ok && v >= static_cast<long long>(std::numeric_limits<T>::min())
+          && v <= static_cast<long long>(std::numeric_limits<T>::max());
+    }
+  }
+  else if constexpr (std::is_floating_point_v<T>) {
+    static_assert(sizeof(T) <= sizeof(double), "long double can't be unboxed");
+    return detail::unbox_number(
+        obj, sizeof(T) == 4 ? detail::number_type::float32 : detail::number_type::float64, &value);
+  }
+  else {
+    static_assert(std::is_trivially_copyable_v<T>, "unboxed structs must be trivially copyable");
+    return detail::unbox_value(obj, &value, sizeof(T));
+  }
+}
+
+template <typename T>
+T unbox(obj_t* obj) {
+  T value{};
+  unbox(obj, value);
+  return value;
+}
+
+} // namespace nano::objc.
+
+NANO_CLANG_DIAGNOSTIC_POP()
+#endif // __APPLE__
@@ -0,0 +1,164 @@
+#include <nano/objc_data.h>
+
+#ifdef __APPLE__
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+  #include <utility>
+
+namespace nano::objc {
+namespace {
+  struct data_selectors {
+    class_t* cls = get_class("NSData");
+    selector_t* alloc = get_selector("alloc");
+    selector_t* init = get_selector("init");
+    selector_t* init_no_copy = get_selector("initWithBytesNoCopy:length:freeWhenDone:");
+    selector_t* init_deallocator = get_selector("initWithBytesNoCopy:length:deallocator:");
+    selector_t* bytes = get_selector("bytes");
+    selector_t* length = get_selector("length");
+
+    static const data_selectors& get() {
+      static const data_selectors s;
+      return s;
+    }
+  };
+
+  struct deallocation {
+    data_view::deallocator_ptr fct;
+    void* context;
+  };
+
+  using deallocator_block = block_literal<void, void*, ns_uint_t>;
+
+  void invoke_deallocation(deallocator_block* block, void* bytes, ns_uint_t length) {
+    // The block was copied by NSData, along with the context pointer.
+    deallocation* d = static_cast<deallocation*>(block->context);
+    d->fct(d->context, static_cast<const std::byte*>(bytes), length);
+    delete d;
+  }
+} // namespace.
+
+data_view::data_view(obj_t* data)
+    : m_data(data) {
+  if (!m_data) {
+    return;
+  }
+
+  const data_selectors& s = data_selectors::get();
+  retain(m_data);
+  m_bytes = static_cast<const std::byte*>(call<const void*>(m_data, s.bytes));
+  m_size = call<ns_uint_t>(m_data, s.length);
+}
+
+data_view::data_view(const data_view& other)
+    : m_data(other.m_data)
+    , m_bytes(other.m_bytes)
+    , m_size(other.m_size) {
+  if (m_data) {
+    retain(m_data);
+  }
+}
+
+data_view::data_view(data_view&& other) noexcept
+    : m_data(std::exchange(other.m_data, nullptr))
+    , m_bytes(std::exchange(other.m_bytes, nullptr))
+    , m_size(std::exchange(other.m_size, 0)) {}
+
+data_view::~data_view() {
+  if (m_data) {
+    release(m_data);
+  }
+}
+
+data_view& data_view::operator=(const data_view& other) {
+  data_view(other).swap(*this);
+  return *this;
+}
+
+data_view& data_view::operator=(data_view&& other) noexcept {
+  data_view(std::move(other)).swap(*this);
+  return *this;
+}
+
+void data_view::swap(data_view& other) noexcept {
+  std::swap(m_data, other.m_data);
+  std::swap(m_bytes, other.m_bytes);
+  std::swap(m_size, other.m_size);
+}
+
+data_view data_view::adopt(obj_t* data) {
+  data_view view(data);
+
+  if (data) {
+    // Balances the retain of the constructor.
+    release(data);
+  }
+
+  return view;
+}
+
+data_view data_view::wrap(const std::byte* data, std::size_t size, deallocator_ptr deallocator, void* context) {
+  const data_selectors& s = data_selectors::get();
+  obj_t* obj = call<obj_t*>(s.cls, s.alloc);
+  void* bytes = const_cast<std::byte*>(data);
+
+  if (!deallocator) {
+    return adopt(call<obj_t*>(obj, s.init_no_copy, bytes, static_cast<ns_uint_t>(size), false));
+  }
+
+  deallocation* d = new deallocation{ deallocator, context };
+  deallocator_block block = make_block<void, void*, ns_uint_t>(&invoke_deallocation, d);
+
+  obj = call<obj_t*>(obj, s.init_deallocator, bytes, static_cast<ns_uint_t>(size), block.get());
+
+  if (!obj) {
+    // The deallocator is never called when the initialization fails.
+    deallocator(context, data, size);
+    delete d;
+    return {};
+  }
+
+  return adopt(obj);
+}
+
+data_view data_view::wrap(std::vector<std::byte>&& buffer) {
+  auto* owned = new std::vector<std::byte>(std::move(buffer));
+
+  return wrap(owned->data(), owned->size(),
+      [](void* context, const std::byte*, std::size_t) { delete static_cast<std::vector<std::byte>*>(context); },
+      owned);
+}
+
+data_view data_view::map_file(const char* path) {
+  const int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return {};
+  }
+
+  struct stat st;
+  if (::fstat(fd, &st) != 0) {
+    ::close(fd);
+    return {};
+  }
+
+  const std::size_t size = static_cast<std::size_t>(st.st_size);
+  if (size == 0) {
+    ::close(fd);
+    const data_selectors& s = data_selectors::get();
+    return adopt(call<obj_t*>(call<obj_t*>(s.cls, s.alloc), s.init));
+  }
+
+  void* mapped = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+
+  if (mapped == MAP_FAILED) {
+    return {};
+  }
+
+  return wrap(static_cast<const std::byte*>(mapped), size, [](void*, const std::byte* data, std::size_t length) {
+    ::munmap(const_cast<std::byte*>(data), length);
+  });
+}
+} // namespace nano::objc.
+#endif // __APPLE__
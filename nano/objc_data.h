@@ -0,0 +1,116 @@
+/*
+ * Nano Library
+ *
+ * Copyright (C) 2026, Meta-Sonic
+ * All rights reserved.
+ *
+ * Proprietary and confidential.
+ * Any unauthorized copying, alteration, distribution, transmission, performance,
+ * display or other use of this material is strictly prohibited.
+ */
+
+#pragma once
+
+/*!
+ * @file      nano/objc_data.h
+ * @brief     nano objc zero-copy NSData
+ * @copyright Copyright (C) 2026, Meta-Sonic
+ * @date      Created 18/10/2026
+ */
+
+#include <nano/objc.h>
+
+#ifdef __APPLE__
+  #include <cstddef>
+  #include <vector>
+
+  #if __has_include(<span>)
+    #include <span>
+  #endif
+
+NANO_CLANG_DIAGNOSTIC_PUSH()
+NANO_CLANG_DIAGNOSTIC(warning, "-Weverything")
+NANO_CLANG_DIAGNOSTIC(ignored, "-Wc++98-compat")
+
+namespace nano::objc {
+
+/// A retained NSData and a view of its bytes.
+///
+/// Buffers are wrapped as NSData without copying (dataWithBytesNoCopy:length:deallocator:), and the bytes
+/// of any NSData are accessed in place.
+///
+/// @remarks A NSMutableData must not be mutated while it's viewed.
+class data_view {
+public:
+  /// Called when the NSData is deallocated, possibly on another thread.
+  using deallocator_ptr = void (*)(void* context, const std::byte* data, std::size_t size);
+
+  data_view() noexcept = default;
+
+  /// Views the bytes of a NSData, the NSData is retained.
+  explicit data_view(obj_t* data);
+
+  data_view(const data_view& other);
+
+  data_view(data_view&& other) noexcept;
+
+  ~data_view();
+
+  data_view& operator=(const data_view& other);
+
+  data_view& operator=(data_view&& other) noexcept;
+
+  void swap(data_view& other) noexcept;
+
+  /// Wraps a buffer as NSData without copying.
+  /// The deallocator is called once the NSData (and anything that retained it) is done with the buffer.
+  /// Without a deallocator, the buffer must outlive the NSData.
+  static data_view wrap(
+      const std::byte* data, std::size_t size, deallocator_ptr deallocator = nullptr, void* context = nullptr);
+
+  /// Moves a buffer into a NSData, the buffer is freed along with the NSData.
+  static data_view wrap(std::vector<std::byte>&& buffer);
+
+  /// Maps a file in memory as NSData. Pages are loaded on access, the file is never read() or copied.
+  /// @returns An empty view if the file can't be opened or mapped.
+  static data_view map_file(const char* path);
+
+  /// The NSData, nullptr for an empty view.
+  inline obj_t* get() const noexcept { return m_data; }
+
+  inline const std::byte* data() const noexcept { return m_bytes; }
+
+  inline std::size_t size() const noexcept { return m_size; }
+
+  inline bool empty() const noexcept { return m_size == 0; }
+
+  inline const std::byte* begin() const noexcept { return m_bytes; }
+
+  inline const std::byte* end() const noexcept { return m_bytes + m_size; }
+
+  inline std::byte operator[](std::size_t index) const noexcept { return m_bytes[index]; }
+
+  inline explicit operator bool() const noexcept { return m_data != nullptr; }
+
+  #if defined(__cpp_lib_span)
+  inline std::span<const std::byte> span() const noexcept { return { m_bytes, m_size }; }
+
+  static inline data_view wrap(
+      std::span<const std::byte> bytes, deallocator_ptr deallocator = nullptr, void* context = nullptr) {
+    return wrap(bytes.data(), bytes.size(), deallocator, context);
+  }
+  #endif // __cpp_lib_span
+
+private:
+  obj_t* m_data = nullptr;
+  const std::byte* m_bytes = nullptr;
+  std::size_t m_size = 0;
+
+  /// Takes ownership of an already retained NSData.
+  static data_view adopt(obj_t* data);
+};
+
+} // namespace nano::objc.
+
+NANO_CLANG_DIAGNOSTIC_POP()
+#endif // __APPLE__
@@ -0,0 +1,772 @@
+#include <nano/objc_invoke.h>
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+
+#ifdef __APPLE__
+  #include <objc/runtime.h>
+#endif // __APPLE__
+
+namespace nano::objc {
+namespace {
+  constexpr std::uint8_t piece_float = 1;
+  constexpr std::uint8_t piece_signed = 2;
+
+#if defined(__aarch64__) || defined(__arm64__)
+  constexpr bool is_arm64 = true;
+  constexpr bool is_supported_arch = true;
+  constexpr std::size_t integer_registers = 8;
+#elif defined(__x86_64__)
+  constexpr bool is_arm64 = false;
+  constexpr bool is_supported_arch = true;
+  constexpr std::size_t integer_registers = 6;
+#else
+  constexpr bool is_arm64 = false;
+  constexpr bool is_supported_arch = false;
+  constexpr std::size_t integer_registers = 0;
+#endif
+
+  // Register slots used by the universal call (on x86_64, the last integer slots are passed on the stack).
+  constexpr std::size_t word_slots = 8;
+  constexpr std::size_t float_slots = 8;
+
+  inline std::size_t align_up(std::size_t value, std::size_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+  }
+
+  inline const char* skip_qualifiers(const char* e) {
+    while (*e && std::strchr("rnNoORVA", *e)) {
+      e++;
+    }
+    return e;
+  }
+
+  inline const char* skip_quoted(const char* e) {
+    if (*e != '"') {
+      return e;
+    }
+
+    e = std::strchr(e + 1, '"');
+    return e ? e + 1 : nullptr;
+  }
+
+  inline const char* skip_digits(const char* e) {
+    if (*e == '-') {
+      e++;
+    }
+
+    while (*e >= '0' && *e <= '9') {
+      e++;
+    }
+    return e;
+  }
+
+  inline const char* parse_count(const char* e, std::size_t& count) {
+    count = 0;
+    while (*e >= '0' && *e <= '9') {
+      count = count * 10 + static_cast<std::size_t>(*e - '0');
+      e++;
+    }
+    return e;
+  }
+
+  inline void set_scalar(type_info& info, type_kind kind, std::size_t size) {
+    info.kind = kind;
+    info.size = static_cast<std::uint32_t>(size);
+    info.alignment = static_cast<std::uint32_t>(size ? size : 1);
+
+    if (kind == type_kind::floating_point) {
+      info.hfa_count = 1;
+      info.hfa_member_size = static_cast<std::uint8_t>(size);
+      info.float_eightbytes = size > 8 ? 0x3 : 0x1;
+    }
+    else {
+      info.integer_eightbytes = size > 8 ? 0x3 : 0x1;
+    }
+  }
+
+  inline std::uint8_t shift_eightbytes(std::uint8_t mask, std::size_t member_size, std::size_t offset) {
+    std::uint8_t result = 0;
+    for (std::size_t i = 0; i < 2; i++) {
+      if (!(mask & (1 << i))) {
+        continue;
+      }
+
+      const std::size_t first = offset + i * 8;
+      const std::size_t last = first + std::min<std::size_t>(8, member_size - i * 8) - 1;
+
+      if (first < 16) {
+        result |= static_cast<std::uint8_t>(1 << (first / 8));
+      }
+
+      if (last < 16) {
+        result |= static_cast<std::uint8_t>(1 << (last / 8));
+      }
+    }
+    return result;
+  }
+
+  /// Layout of the members of a struct, union or array.
+  struct aggregate_builder {
+    type_info& info;
+    bool is_union = false;
+    bool hfa = true;
+    std::size_t offset = 0;
+    std::size_t hfa_count = 0;
+
+    inline void add(const type_info& m) {
+      const std::size_t member_offset = is_union ? 0 : align_up(offset, m.alignment);
+
+      info.alignment = std::max(info.alignment, m.alignment);
+      info.exact = info.exact && m.exact;
+
+      if (member_offset < 16 && m.size <= 16) {
+        info.integer_eightbytes |= shift_eightbytes(m.integer_eightbytes, m.size, member_offset);
+        info.float_eightbytes |= shift_eightbytes(m.float_eightbytes, m.size, member_offset);
+      }
+
+      if (is_union || !m.hfa_count || (info.hfa_member_size && info.hfa_member_size != m.hfa_member_size)) {
+        hfa = false;
+      }
+      else {
+        info.hfa_member_size = m.hfa_member_size;
+        hfa_count += m.hfa_count;
+      }
+
+      offset = is_union ? std::max<std::size_t>(offset, m.size) : member_offset + m.size;
+    }
+
+    inline void finish() {
+      info.size = static_cast<std::uint32_t>(align_up(offset, info.alignment));
+
+      if (hfa && hfa_count > 0 && hfa_count <= 4) {
+        info.hfa_count = static_cast<std::uint8_t>(hfa_count);
+      }
+      else {
+        info.hfa_count = 0;
+        info.hfa_member_size = 0;
+      }
+    }
+  };
+
+  const char* parse_type(const char* e, type_info& info) noexcept;
+
+  /// Parses "{name=members}" or "(name=members)", e points after the opening character.
+  const char* parse_aggregate(const char* e, type_info& info, char close, bool is_union) noexcept {
+    info.kind = is_union ? type_kind::union_type : type_kind::structure;
+
+    while (*e && *e != '=' && *e != close) {
+      e++;
+    }
+
+    if (*e == close) {
+      // Opaque.
+      info.exact = false;
+      return e + 1;
+    }
+
+    if (*e != '=') {
+      return nullptr;
+    }
+
+    e++;
+
+    aggregate_builder builder = { info, is_union };
+
+    while (*e && *e != close) {
+      if (!(e = skip_quoted(e))) {
+        return nullptr;
+      }
+
+      type_info m;
+      if (!(e = parse_type(e, m))) {
+        return nullptr;
+      }
+
+      builder.add(m);
+    }
+
+    if (*e != close) {
+      return nullptr;
+    }
+
+    builder.finish();
+    return e + 1;
+  }
+
+  const char* parse_type(const char* e, type_info& info) noexcept {
+    info = type_info();
+    e = skip_qualifiers(e);
+
+    switch (*e++) {
+    case 'v':
+      info.kind = type_kind::void_type;
+      return e;
+
+    case 'c':
+      set_scalar(info, type_kind::signed_integer, 1);
+      return e;
+    case 'C':
+    case 'B':
+      set_scalar(info, type_kind::unsigned_integer, 1);
+      return e;
+    case 's':
+      set_scalar(info, type_kind::signed_integer, 2);
+      return e;
+    case 'S':
+      set_scalar(info, type_kind::unsigned_integer, 2);
+      return e;
+    case 'i':
+    case 'l':
+      set_scalar(info, type_kind::signed_integer, 4);
+      return e;
+    case 'I':
+    case 'L':
+      set_scalar(info, type_kind::unsigned_integer, 4);
+      return e;
+    case 'q':
+      set_scalar(info, type_kind::signed_integer, 8);
+      return e;
+    case 'Q':
+      set_scalar(info, type_kind::unsigned_integer, 8);
+      return e;
+    case 't':
+      set_scalar(info, type_kind::signed_integer, 16);
+      return e;
+    case 'T':
+      set_scalar(info, type_kind::unsigned_integer, 16);
+      return e;
+
+    case 'f':
+      set_scalar(info, type_kind::floating_point, sizeof(float));
+      return e;
+    case 'd':
+      set_scalar(info, type_kind::floating_point, sizeof(double));
+      return e;
+    case 'D':
+      set_scalar(info, type_kind::floating_point, sizeof(long double));
+      return e;
+
+    case '*':
+      set_scalar(info, type_kind::c_string, sizeof(void*));
+      return e;
+    case '#':
+      set_scalar(info, type_kind::class_object, sizeof(void*));
+      return e;
+    case ':':
+      set_scalar(info, type_kind::selector, sizeof(void*));
+      return e;
+
+    case '@':
+      set_scalar(info, type_kind::object, sizeof(void*));
+
+      // Block (@?) or class name (@"NSString").
+      if (*e == '?') {
+        return e + 1;
+      }
+      return skip_quoted(e);
+
+    case '^': {
+      type_info pointee;
+      if (!(e = parse_type(e, pointee))) {
+        return nullptr;
+      }
+
+      set_scalar(info, type_kind::pointer, sizeof(void*));
+      return e;
+    }
+
+    case '?':
+      // Unknown type (e.g. function pointer ^?).
+      info.exact = false;
+      return e;
+
+    case 'b': {
+      std::size_t bits = 0;
+      e = parse_count(e, bits);
+      info.kind = type_kind::bitfield;
+      info.size = static_cast<std::uint32_t>((bits + 7) / 8);
+      info.integer_eightbytes = 0x1;
+      info.exact = false;
+      return e;
+    }
+
+    case 'j': {
+      // Complex.
+      type_info element;
+      if (!(e = parse_type(e, element))) {
+        return nullptr;
+      }
+
+      aggregate_builder builder = { info };
+      info.kind = type_kind::structure;
+      builder.add(element);
+      builder.add(element);
+      builder.finish();
+      return e;
+    }
+
+    case '[': {
+      std::size_t count = 0;
+      e = parse_count(e, count);
+
+      type_info element;
+      if (!(e = parse_type(e, element)) || *e != ']') {
+        return nullptr;
+      }
+
+      aggregate_builder builder = { info };
+      info.kind = type_kind::array;
+      for (std::size_t i = 0; i < count; i++) {
+        builder.add(element);
+      }
+
+      builder.finish();
+      return e + 1;
+    }
+
+    case '{':
+      return parse_aggregate(e, info, '}', false);
+
+    case '(':
+      return parse_aggregate(e, info, ')', true);
+
+    default:
+      return nullptr;
+    }
+  }
+
+  inline bool is_integer_scalar(type_kind kind) {
+    switch (kind) {
+    case type_kind::signed_integer:
+    case type_kind::unsigned_integer:
+    case type_kind::object:
+    case type_kind::class_object:
+    case type_kind::selector:
+    case type_kind::c_string:
+    case type_kind::pointer:
+      return true;
+    default:
+      return false;
+    }
+  }
+
+  inline bool is_aggregate(type_kind kind) {
+    return kind == type_kind::structure || kind == type_kind::array || kind == type_kind::union_type;
+  }
+
+  /// SysV x86_64 classification of an eightbyte.
+  inline bool is_sse_eightbyte(const type_info& info, std::size_t index) {
+    return (info.float_eightbytes & (1 << index)) && !(info.integer_eightbytes & (1 << index));
+  }
+
+  struct universal_integer_return {
+    std::uint64_t w0;
+    std::uint64_t w1;
+  };
+
+#if defined(__aarch64__) || defined(__arm64__)
+  // Homogeneous aggregate, returned in v0-v3.
+  struct universal_float_return {
+    double d[4];
+  };
+#else
+  // Returned in xmm0 and xmm1.
+  struct universal_float_return {
+    double d[2];
+  };
+#endif
+
+  struct universal_integer_float_return {
+    std::uint64_t w0;
+    double d0;
+  };
+
+  struct universal_float_integer_return {
+    double d0;
+    std::uint64_t w0;
+  };
+
+  struct universal_memory_return {
+    unsigned char bytes[dynamic_invoker::max_return_size];
+  };
+
+  template <typename R>
+  inline R universal_call(dynamic_invoker::function_ptr fct, const std::uint64_t* w, const double* d) noexcept {
+    using fct_type = R (*)(std::uint64_t, std::uint64_t, std::uint64_t, std::uint64_t, std::uint64_t, std::uint64_t,
+        std::uint64_t, std::uint64_t, double, double, double, double, double, double, double, double);
+
+    return reinterpret_cast<fct_type>(fct)(w[0], w[1], w[2], w[3], w[4], w[5], w[6], w[7], //
+        d[0], d[1], d[2], d[3], d[4], d[5], d[6], d[7]);
+  }
+
+  inline std::uint64_t load_signed(const unsigned char* src, std::size_t size) {
+    switch (size) {
+    case 1: {
+      std::int8_t v;
+      std::memcpy(&v, src, 1);
+      return static_cast<std::uint64_t>(static_cast<std::int64_t>(v));
+    }
+    case 2: {
+      std::int16_t v;
+      std::memcpy(&v, src, 2);
+      return static_cast<std::uint64_t>(static_cast<std::int64_t>(v));
+    }
+    case 4: {
+      std::int32_t v;
+      std::memcpy(&v, src, 4);
+      return static_cast<std::uint64_t>(static_cast<std::int64_t>(v));
+    }
+    default: {
+      std::int64_t v;
+      std::memcpy(&v, src, 8);
+      return static_cast<std::uint64_t>(v);
+    }
+    }
+  }
+} // namespace.
+
+//
+// Type encoding.
+//
+
+const char* parse_type_encoding(const char* encoding, type_info& info) noexcept {
+  return encoding ? parse_type(encoding, info) : nullptr;
+}
+
+std::size_t get_encoding_size(const char* encoding) noexcept {
+  type_info info;
+  return parse_type_encoding(encoding, info) ? info.size : 0;
+}
+
+bool method_signature::parse(const char* encoding) noexcept {
+  m_valid = false;
+  m_count = 0;
+  m_arguments_size = 0;
+
+  const char* e = parse_type_encoding(encoding, m_return);
+  if (!e) {
+    return false;
+  }
+
+  e = skip_digits(e);
+
+  std::size_t offset = 0;
+  while (*e) {
+    if (m_count == max_arguments) {
+      return false;
+    }
+
+    type_info& arg = m_arguments[m_count];
+    if (!(e = parse_type(e, arg))) {
+      return false;
+    }
+
+    e = skip_digits(e);
+
+    // self and _cmd are not part of the arguments buffer.
+    if (m_count >= 2) {
+      offset = align_up(offset, arg.alignment);
+      m_offsets[m_count] = static_cast<std::uint16_t>(offset);
+      offset += arg.size;
+    }
+
+    m_count++;
+  }
+
+  m_arguments_size = static_cast<std::uint16_t>(offset);
+  m_valid = m_count >= 2;
+  return m_valid;
+}
+
+//
+// Dynamic invoker.
+//
+
+bool dynamic_invoker::prepare_signature(const method_signature& signature, prepared_call& call) noexcept {
+  using shape_type = prepared_call::return_shape;
+
+  if (!is_supported_arch || !signature.valid()) {
+    return false;
+  }
+
+  call.signature = signature;
+  call.piece_count = 0;
+  call.return_piece_count = 0;
+
+  auto add_return_piece = [&](std::size_t offset, std::size_t size, std::size_t reg, std::uint8_t flags) {
+    call.return_pieces[call.return_piece_count++]
+        = { static_cast<std::uint16_t>(offset), static_cast<std::uint8_t>(size), static_cast<std::uint8_t>(reg), flags };
+  };
+
+  auto add_piece = [&](std::size_t offset, std::size_t size, std::size_t reg, std::uint8_t flags) {
+    call.pieces[call.piece_count++]
+        = { static_cast<std::uint16_t>(offset), static_cast<std::uint8_t>(size), static_cast<std::uint8_t>(reg), flags };
+  };
+
+  //
+  // Return value.
+  //
+  const type_info& ret = signature.return_type();
+
+  if (ret.kind == type_kind::void_type) {
+    call.shape = shape_type::none;
+  }
+  else if (is_integer_scalar(ret.kind)) {
+    call.shape = shape_type::integer;
+    add_return_piece(0, std::min<std::size_t>(ret.size, 8), 0, 0);
+
+    if (ret.size > 8) {
+      add_return_piece(8, ret.size - 8, 1, 0);
+    }
+  }
+  else if (ret.kind == type_kind::floating_point) {
+    if (ret.size > 8) {
+      return false;
+    }
+
+    call.shape = shape_type::floating_point;
+    add_return_piece(0, ret.size, 0, piece_float);
+  }
+  else if (is_aggregate(ret.kind) && ret.exact) {
+    if (is_arm64 && ret.hfa_count && ret.hfa_member_size <= 8) {
+      call.shape = shape_type::floating_point;
+      for (std::size_t i = 0; i < ret.hfa_count; i++) {
+        add_return_piece(i * ret.hfa_member_size, ret.hfa_member_size, i, piece_float);
+      }
+    }
+    else if (ret.size <= 16) {
+      const bool sse0 = !is_arm64 && is_sse_eightbyte(ret, 0);
+      const bool sse1 = !is_arm64 && ret.size > 8 && is_sse_eightbyte(ret, 1);
+
+      if (ret.size <= 8) {
+        call.shape = sse0 ? shape_type::floating_point : shape_type::integer;
+        add_return_piece(0, ret.size, 0, sse0 ? piece_float : 0);
+      }
+      else {
+        call.shape = sse0 == sse1 ? (sse0 ? shape_type::floating_point : shape_type::integer)
+                                  : (sse0 ? shape_type::float_integer : shape_type::integer_float);
+
+        // Each eightbyte goes in the next register of its class.
+        add_return_piece(0, 8, 0, sse0 ? piece_float : 0);
+        add_return_piece(8, ret.size - 8, sse0 == sse1 ? 1 : 0, sse1 ? piece_float : 0);
+      }
+    }
+    else if (ret.size <= max_return_size) {
+      call.shape = shape_type::memory;
+    }
+    else {
+      return false;
+    }
+  }
+  else {
+    return false;
+  }
+
+  //
+  // Arguments.
+  //
+
+  // On x86_64, the address of a struct returned in memory is passed in the first integer register.
+  const std::size_t registers = integer_registers - (!is_arm64 && call.shape == shape_type::memory ? 1 : 0);
+
+  // self and _cmd.
+  std::size_t w = 2;
+  std::size_t f = 0;
+
+  for (std::size_t i = 2; i < signature.argument_count(); i++) {
+    const type_info& arg = signature.argument(i);
+    const std::size_t offset = signature.argument_offset(i);
+
+    if (is_integer_scalar(arg.kind) && arg.size <= 8) {
+      // On arm64 all word slots are registers, on x86_64 the ones past the registers are
+      // passed on the stack in order.
+      if (w == word_slots) {
+        return false;
+      }
+
+      add_piece(offset, arg.size, w++, arg.kind == type_kind::signed_integer ? piece_signed : 0);
+    }
+    else if (arg.kind == type_kind::floating_point && arg.size <= 8) {
+      if (f == float_slots) {
+        return false;
+      }
+
+      add_piece(offset, arg.size, f++, piece_float);
+    }
+    else if (is_aggregate(arg.kind) && arg.exact) {
+      if (is_arm64 && arg.hfa_count && arg.hfa_member_size <= 8) {
+        if (f + arg.hfa_count > float_slots) {
+          return false;
+        }
+
+        for (std::size_t k = 0; k < arg.hfa_count; k++) {
+          add_piece(offset + k * arg.hfa_member_size, arg.hfa_member_size, f++, piece_float);
+        }
+      }
+      else if (arg.size <= 16 && arg.size > 0) {
+        const std::size_t count = (arg.size + 7) / 8;
+        std::size_t sse_count = 0;
+
+        for (std::size_t k = 0; k < count; k++) {
+          sse_count += !is_arm64 && is_sse_eightbyte(arg, k);
+        }
+
+        // Structs are never split between registers and the stack.
+        if (w + count - sse_count > registers || f + sse_count > float_slots) {
+          return false;
+        }
+
+        for (std::size_t k = 0; k < count; k++) {
+          const std::size_t size = std::min<std::size_t>(8, arg.size - k * 8);
+
+          if (!is_arm64 && is_sse_eightbyte(arg, k)) {
+            add_piece(offset + k * 8, size, f++, piece_float);
+          }
+          else {
+            add_piece(offset + k * 8, size, w++, 0);
+          }
+        }
+      }
+      else {
+        // Passed by reference (arm64) or on the stack (x86_64).
+        return false;
+      }
+    }
+    else {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+void dynamic_invoker::invoke(const prepared_call& call, void* obj, const void* args, void* result) noexcept {
+  using shape_type = prepared_call::return_shape;
+
+  std::uint64_t w[word_slots] = {};
+  double d[float_slots] = {};
+  std::uint64_t rw[2] = {};
+  double rd[4] = {};
+
+  w[0] = reinterpret_cast<std::uintptr_t>(obj);
+  w[1] = reinterpret_cast<std::uintptr_t>(call.sel);
+
+  const unsigned char* src = static_cast<const unsigned char*>(args);
+
+  for (std::size_t i = 0; i < call.piece_count; i++) {
+    const prepared_call::piece& p = call.pieces[i];
+
+    if (p.flags & piece_float) {
+      std::uint64_t bits = 0;
+      std::memcpy(&bits, src + p.offset, p.size);
+      std::memcpy(&d[p.reg], &bits, sizeof(bits));
+    }
+    else if (p.flags & piece_signed) {
+      w[p.reg] = load_signed(src + p.offset, p.size);
+    }
+    else {
+      std::uint64_t bits = 0;
+      std::memcpy(&bits, src + p.offset, p.size);
+      w[p.reg] = bits;
+    }
+  }
+
+  switch (call.shape) {
+  case shape_type::none:
+  case shape_type::integer: {
+    universal_integer_return r = universal_call<universal_integer_return>(call.fct, w, d);
+    rw[0] = r.w0;
+    rw[1] = r.w1;
+  } break;
+
+  case shape_type::floating_point: {
+    universal_float_return r = universal_call<universal_float_return>(call.fct, w, d);
+    std::memcpy(rd, r.d, sizeof(r.d));
+  } break;
+
+  case shape_type::integer_float: {
+    universal_integer_float_return r = universal_call<universal_integer_float_return>(call.fct, w, d);
+    rw[0] = r.w0;
+    rd[0] = r.d0;
+  } break;
+
+  case shape_type::float_integer: {
+    universal_float_integer_return r = universal_call<universal_float_integer_return>(call.fct, w, d);
+    rd[0] = r.d0;
+    rw[0] = r.w0;
+  } break;
+
+  case shape_type::memory: {
+    universal_memory_return r = universal_call<universal_memory_return>(call.fct, w, d);
+    if (result) {
+      std::memcpy(result, r.bytes, call.signature.return_type().size);
+    }
+  }
+    return;
+  }
+
+  if (!result) {
+    return;
+  }
+
+  unsigned char* dst = static_cast<unsigned char*>(result);
+  for (std::size_t i = 0; i < call.return_piece_count; i++) {
+    const prepared_call::piece& p = call.return_pieces[i];
+    const void* reg = (p.flags & piece_float) ? static_cast<const void*>(&rd[p.reg]) : &rw[p.reg];
+    std::memcpy(dst + p.offset, reg, p.size);
+  }
+}
+
+#ifdef __APPLE__
+const dynamic_invoker::prepared_call* dynamic_invoker::prepare(class_t* c, selector_t* sel) {
+  const std::pair<void*, void*> key = { c, sel };
+
+  // Read before preparing, a class mutated meanwhile is prepared again on the next call.
+  const std::uint64_t generation = get_runtime_generation();
+
+  {
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    auto it = m_calls.find(key);
+    if (it != m_calls.end() && it->second.generation == generation) {
+      return it->second.call.get();
+    }
+  }
+
+  // Unsupported methods are cached as nullptr.
+  auto call = std::make_unique<prepared_call>();
+  Method method = class_getInstanceMethod(c, sel);
+
+  if (!method || !call->signature.parse(method_getTypeEncoding(method))
+      || !prepare_signature(call->signature, *call)) {
+    call.reset();
+  }
+  else {
+    call->sel = sel;
+    call->fct = call->shape == prepared_call::return_shape::memory ? get_class_method_implementation_stret(c, sel)
+                                                                   : get_class_method_implementation(c, sel);
+  }
+
+  std::unique_lock<std::shared_mutex> lock(m_mutex);
+  cache_entry& entry = m_calls[key];
+  entry.generation = generation;
+
+  // Most mutations are unrelated to this method, the previous call is kept when it's unchanged.
+  const auto is_same = [](const prepared_call& a, const prepared_call& b) {
+    return a.fct == b.fct && a.shape == b.shape && a.signature.argument_count() == b.signature.argument_count()
+        && a.signature.arguments_size() == b.signature.arguments_size();
+  };
+
+  if (entry.call && call && is_same(*entry.call, *call)) {
+    return entry.call.get();
+  }
+
+  if (entry.call) {
+    m_retired.push_back(std::move(entry.call));
+  }
+
+  entry.call = std::move(call);
+  return entry.call.get();
+}
+#endif // __APPLE__
+} // namespace nano::objc.
@@ -0,0 +1,208 @@
+/*
+ * Nano Library
+ *
+ * Copyright (C) 2026, Meta-Sonic
+ * All rights reserved.
+ *
+ * Proprietary and confidential.
+ * Any unauthorized copying, alteration, distribution, transmission, performance,
+ * display or other use of this material is strictly prohibited.
+ */
+
+#pragma once
+
+/*!
+ * @file      nano/objc_invoke.h
+ * @brief     nano objc type encoding parser and dynamic invoker
+ * @copyright Copyright (C) 2026, Meta-Sonic
+ * @date      Created 18/10/2026
+ */
+
+#include <nano/objc.h>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+NANO_CLANG_DIAGNOSTIC_PUSH()
+NANO_CLANG_DIAGNOSTIC(warning, "-Weverything")
+NANO_CLANG_DIAGNOSTIC(ignored, "-Wc++98-compat")
+
+namespace nano::objc {
+
+enum class type_kind : std::uint8_t {
+  unknown,
+  void_type,
+  signed_integer,
+  unsigned_integer,
+  floating_point,
+  object,
+  class_object,
+  selector,
+  c_string,
+  pointer,
+  structure,
+  array,
+  union_type,
+  bitfield
+};
+
+/// Layout of a type parsed from an objc type encoding (e.g. "i", "^v" or "{CGPoint=dd}").
+struct type_info {
+  type_kind kind = type_kind::unknown;
+  std::uint32_t size = 0;
+  std::uint32_t alignment = 1;
+
+  /// Homogeneous floating point aggregate, number of members (zero if not an hfa) and size of each member.
+  std::uint8_t hfa_count = 0;
+  std::uint8_t hfa_member_size = 0;
+
+  /// Eightbytes containing integer or floating point data (bit i is the ith eightbyte).
+  /// Only meaningful for types of 16 bytes or less.
+  std::uint8_t integer_eightbytes = 0;
+  std::uint8_t float_eightbytes = 0;
+
+  /// False when the layout can't be deduced exactly (e.g. bitfields or opaque structs).
+  bool exact = true;
+};
+
+/// Parses a single type.
+/// @returns A pointer past the parsed type, or nullptr if the encoding is invalid.
+const char* parse_type_encoding(const char* encoding, type_info& info) noexcept;
+
+/// Size of the type described by a type encoding, zero if the encoding is invalid.
+std::size_t get_encoding_size(const char* encoding) noexcept;
+
+/// Parsed method type encoding (e.g. "v@:@" or "v24@0:8@16"), as returned by method_getTypeEncoding().
+///
+/// Arguments include self and _cmd. The explicit arguments (index >= 2) are expected in a packed
+/// buffer where each argument is at argument_offset(index), aligned to its natural alignment.
+class method_signature {
+public:
+  static constexpr std::size_t max_arguments = 16;
+
+  method_signature() noexcept = default;
+
+  inline method_signature(const char* encoding) noexcept { parse(encoding); }
+
+  bool parse(const char* encoding) noexcept;
+
+  inline bool valid() const noexcept { return m_valid; }
+
+  inline const type_info& return_type() const noexcept { return m_return; }
+
+  inline std::size_t argument_count() const noexcept { return m_count; }
+
+  inline const type_info& argument(std::size_t index) const noexcept { return m_arguments[index]; }
+
+  inline std::size_t argument_offset(std::size_t index) const noexcept { return m_offsets[index]; }
+
+  /// Size of the packed arguments buffer.
+  inline std::size_t arguments_size() const noexcept { return m_arguments_size; }
+
+private:
+  type_info m_return;
+  type_info m_arguments[max_arguments];
+  std::uint16_t m_offsets[max_arguments] = {};
+  std::uint16_t m_arguments_size = 0;
+  std::uint8_t m_count = 0;
+  bool m_valid = false;
+};
+
+/// Calls methods whose signature is only known at runtime, without NSInvocation or libffi.
+///
+/// A prepared call maps each argument to the registers it is passed in for the current
+/// architecture (arm64 or x86_64) and is cached per (class, selector). Invoking a prepared
+/// call doesn't allocate.
+///
+/// Supported types are scalars, pointers, objects and structs passed in registers
+/// (homogeneous floating point aggregates and structs of 16 bytes or less).
+/// Arguments passed on the stack on arm64, variadic methods, long double and 128-bit
+/// integers are not supported and prepare() returns nullptr for them.
+class dynamic_invoker {
+public:
+  using function_ptr = void (*)();
+
+  static constexpr std::size_t max_return_size = 256;
+
+  struct prepared_call {
+    /// Part of an argument or of the return value held in a single register.
+    struct piece {
+      std::uint16_t offset;
+      std::uint8_t size;
+      std::uint8_t reg;
+      std::uint8_t flags;
+    };
+
+    enum class return_shape : std::uint8_t { none, integer, floating_point, integer_float, float_integer, memory };
+
+    function_ptr fct = nullptr;
+    void* sel = nullptr;
+    method_signature signature;
+    return_shape shape = return_shape::none;
+    std::uint8_t piece_count = 0;
+    std::uint8_t return_piece_count = 0;
+    piece pieces[16] = {};
+    piece return_pieces[4] = {};
+  };
+
+  dynamic_invoker() = default;
+
+  dynamic_invoker(const dynamic_invoker&) = delete;
+
+  dynamic_invoker& operator=(const dynamic_invoker&) = delete;
+
+  /// Builds a prepared call from a signature, the function and selector are not set.
+  /// @returns false if the signature is not supported.
+  static bool prepare_signature(const method_signature& signature, prepared_call& call) noexcept;
+
+  /// Calls fct(obj, sel, args...).
+  /// @param args Packed arguments (see method_signature::argument_offset()).
+  /// @param result Buffer of at least signature.return_type().size bytes, can be nullptr.
+  static void invoke(const prepared_call& call, void* obj, const void* args, void* result) noexcept;
+
+#ifdef __APPLE__
+  /// Returns the cached call for (c, sel), or nullptr if the method doesn't exist or its signature is not supported.
+  ///
+  /// A call cached before a class was mutated or disposed is prepared again, i.e. after invalidate_runtime_caches()
+  /// (see get_runtime_generation()).
+  /// The returned pointer stays valid until the invoker is destroyed, even if the method is replaced.
+  const prepared_call* prepare(class_t* c, selector_t* sel);
+
+  /// @returns false if the call could not be prepared.
+  inline bool invoke(obj_t* obj, selector_t* sel, const void* args, void* result) {
+    const prepared_call* call = prepare(get_obj_class(obj), sel);
+    if (!call) {
+      return false;
+    }
+
+    invoke(*call, obj, args, result);
+    return true;
+  }
+#endif // __APPLE__
+
+private:
+  struct key_hash {
+    inline std::size_t operator()(const std::pair<void*, void*>& k) const noexcept {
+      return std::hash<void*>()(k.first) ^ (std::hash<void*>()(k.second) << 1);
+    }
+  };
+
+  struct cache_entry {
+    /// nullptr when the method doesn't exist or is not supported.
+    std::unique_ptr<prepared_call> call;
+    std::uint64_t generation = 0;
+  };
+
+  std::shared_mutex m_mutex;
+  std::unordered_map<std::pair<void*, void*>, cache_entry, key_hash> m_calls;
+
+  /// Calls replaced after a class was mutated, pointers to them may still be in use.
+  std::vector<std::unique_ptr<prepared_call>> m_retired;
+};
+
+} // namespace nano::objc.
+
+NANO_CLANG_DIAGNOSTIC_POP()
@@ -0,0 +1,233 @@
+#include <nano/objc_thread_queue.h>
+#include <algorithm>
+#include <cassert>
+
+#ifdef __APPLE__
+  #include <CoreFoundation/CoreFoundation.h>
+#endif // __APPLE__
+
+namespace nano::objc {
+namespace {
+  inline std::size_t next_power_of_two(std::size_t value) {
+    std::size_t p = 2;
+    while (p < value) {
+      p <<= 1;
+    }
+    return p;
+  }
+
+  inline std::size_t hash_call(void* receiver, void* selector) {
+    std::size_t h = reinterpret_cast<std::size_t>(receiver) * 0x9E3779B97F4A7C15ULL;
+    return h ^ (reinterpret_cast<std::size_t>(selector) >> 3);
+  }
+} // namespace.
+
+thread_queue::thread_queue(std::size_t capacity, std::size_t batch_size)
+    : m_mask(next_power_of_two(capacity) - 1)
+    , m_batch_size(std::max<std::size_t>(batch_size, 1)) {
+
+  m_cells = std::make_unique<cell[]>(m_mask + 1);
+  for (std::size_t i = 0; i <= m_mask; i++) {
+    m_cells[i].sequence.store(i, std::memory_order_relaxed);
+  }
+
+  m_batch.reserve(m_batch_size);
+  m_table.resize(next_power_of_two(m_batch_size * 2), 0);
+}
+
+thread_queue::~thread_queue() {
+#ifdef __APPLE__
+  detach_from_run_loop();
+#endif // __APPLE__
+
+  request req;
+  while (pop(req)) {
+    if (req.discard) {
+      req.discard(req.receiver);
+    }
+  }
+}
+
+void thread_queue::set_wakeup(wakeup_ptr fct, void* data) {
+  m_wakeup = fct;
+  m_wakeup_data = data;
+}
+
+bool thread_queue::push(void* receiver, void* selector, invoke_ptr invoke, discard_ptr discard, const void* params,
+    std::size_t size, bool coalesce) {
+  assert(size <= max_params_size);
+
+  std::size_t pos = m_tail.value.load(std::memory_order_relaxed);
+  cell* c = nullptr;
+
+  for (;;) {
+    c = &m_cells[pos & m_mask];
+    std::size_t seq = c->sequence.load(std::memory_order_acquire);
+    std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+
+    if (diff == 0) {
+      if (m_tail.value.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+        break;
+      }
+    }
+    else if (diff < 0) {
+      // Full.
+      return false;
+    }
+    else {
+      pos = m_tail.value.load(std::memory_order_relaxed);
+    }
+  }
+
+  c->req.receiver = receiver;
+  c->req.selector = selector;
+  c->req.invoke = invoke;
+  c->req.discard = discard;
+  c->req.coalesce = coalesce;
+  std::memcpy(c->req.params, params, size);
+  c->sequence.store(pos + 1, std::memory_order_release);
+
+  if (m_pending.fetch_add(1, std::memory_order_acq_rel) == 0 && m_wakeup) {
+    m_wakeup(m_wakeup_data);
+  }
+
+  return true;
+}
+
+bool thread_queue::pop(request& req) {
+  std::size_t pos = m_head.value.load(std::memory_order_relaxed);
+  cell& c = m_cells[pos & m_mask];
+
+  if (c.sequence.load(std::memory_order_acquire) != pos + 1) {
+    // Empty or the producer is still writing this cell.
+    return false;
+  }
+
+  req = c.req;
+  c.sequence.store(pos + m_mask + 1, std::memory_order_release);
+  m_head.value.store(pos + 1, std::memory_order_relaxed);
+  return true;
+}
+
+std::size_t thread_queue::pump() {
+  request req;
+  bool has_coalesce = false;
+
+  m_batch.clear();
+  while (m_batch.size() < m_batch_size && pop(req)) {
+    has_coalesce |= req.coalesce;
+    m_batch.push_back(req);
+  }
+
+  const std::size_t popped = m_batch.size();
+
+  if (has_coalesce) {
+    // Walk backward so that the last call of each (receiver, selector) pair is kept.
+    std::fill(m_table.begin(), m_table.end(), 0);
+    const std::size_t table_mask = m_table.size() - 1;
+
+    for (std::size_t i = popped; i-- > 0;) {
+      request& r = m_batch[i];
+      if (!r.coalesce) {
+        continue;
+      }
+
+      for (std::size_t k = hash_call(r.receiver, r.selector) & table_mask;; k = (k + 1) & table_mask) {
+        if (m_table[k] == 0) {
+          m_table[k] = i + 1;
+          break;
+        }
+
+        const request& kept = m_batch[m_table[k] - 1];
+        if (kept.receiver == r.receiver && kept.selector == r.selector) {
+          if (r.discard) {
+            r.discard(r.receiver);
+          }
+
+          r.invoke = nullptr;
+          m_coalesced_count++;
+          break;
+        }
+      }
+    }
+  }
+
+  std::size_t invoked = 0;
+  for (const request& r : m_batch) {
+    if (r.invoke) {
+      r.invoke(r.receiver, r.selector, r.params);
+      invoked++;
+    }
+  }
+
+  if (popped == 0 && m_pending.load(std::memory_order_acquire) <= 0) {
+    return 0;
+  }
+
+  // Calls pushed while draining (or not fully written yet) need another pump.
+  std::ptrdiff_t remaining
+      = m_pending.fetch_sub(static_cast<std::ptrdiff_t>(popped), std::memory_order_acq_rel)
+      - static_cast<std::ptrdiff_t>(popped);
+
+  if (remaining > 0 && m_wakeup) {
+    m_wakeup(m_wakeup_data);
+  }
+
+  return invoked;
+}
+
+std::size_t thread_queue::pump_all() {
+  std::size_t invoked = 0;
+  while (!empty()) {
+    invoked += pump();
+  }
+
+  return invoked;
+}
+
+std::size_t thread_queue::size() const noexcept {
+  return static_cast<std::size_t>(std::max<std::ptrdiff_t>(m_pending.load(std::memory_order_acquire), 0));
+}
+
+#ifdef __APPLE__
+void thread_queue::release_receiver(void* receiver) { objc::release(static_cast<obj_t*>(receiver)); }
+
+void thread_queue::attach_to_main_run_loop() {
+  if (m_source) {
+    return;
+  }
+
+  CFRunLoopSourceContext context = {};
+  context.info = this;
+  context.perform = [](void* info) { static_cast<thread_queue*>(info)->pump(); };
+
+  CFRunLoopSourceRef source = CFRunLoopSourceCreate(kCFAllocatorDefault, 0, &context);
+  CFRunLoopAddSource(CFRunLoopGetMain(), source, kCFRunLoopCommonModes);
+  m_source = const_cast<void*>(static_cast<const void*>(source));
+
+  set_wakeup(
+      [](void* data) {
+        CFRunLoopSourceSignal(static_cast<CFRunLoopSourceRef>(data));
+        CFRunLoopWakeUp(CFRunLoopGetMain());
+      },
+      m_source);
+
+  if (!empty()) {
+    m_wakeup(m_wakeup_data);
+  }
+}
+
+void thread_queue::detach_from_run_loop() {
+  if (!m_source) {
+    return;
+  }
+
+  CFRunLoopSourceRef source = static_cast<CFRunLoopSourceRef>(m_source);
+  CFRunLoopSourceInvalidate(source);
+  CFRelease(source);
+
+  m_source = nullptr;
+  set_wakeup(nullptr, nullptr);
+}
+#endif // __APPLE__
+} // namespace nano::objc.
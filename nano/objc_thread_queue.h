@@ -0,0 +1,307 @@
+/*
+ * Nano Library
+ *
+ * Copyright (C) 2026, Meta-Sonic
+ * All rights reserved.
+ *
+ * Proprietary and confidential.
+ * Any unauthorized copying, alteration, distribution, transmission, performance,
+ * display or other use of this material is strictly prohibited.
+ */
+
+#pragma once
+
+/*!
+ * @file      nano/objc_thread_queue.h
+ * @brief     nano objc cross-thread message queue
+ * @copyright Copyright (C) 2026, Meta-Sonic
+ * @date      Created 18/10/2026
+ */
+
+#include <nano/objc.h>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+NANO_CLANG_DIAGNOSTIC_PUSH()
+NANO_CLANG_DIAGNOSTIC(warning, "-Weverything")
+NANO_CLANG_DIAGNOSTIC(ignored, "-Wc++98-compat")
+
+namespace nano::objc {
+
+/// Multiple producers, single consumer queue of calls to be made on one thread (usually the main thread).
+///
+/// Producers push calls into a bounded lock-free ring buffer and the consumer drains them in batches,
+/// either by calling pump() or from a run loop source (see attach_to_main_run_loop()).
+///
+/// Calls pushed with push_coalesced() are coalesced by (receiver, selector) within a batch:
+/// only the last one is invoked, at the position of the last one.
+///
+/// @remarks The wakeup callback is only called when the queue goes from empty to non-empty,
+///          a burst of pushes results in a single wakeup.
+class thread_queue {
+public:
+  static constexpr std::size_t max_params_size = 48;
+
+  using invoke_ptr = void (*)(void* receiver, void* selector, const void* params);
+  using discard_ptr = void (*)(void* receiver);
+  using wakeup_ptr = void (*)(void* data);
+
+  /// @param capacity Rounded up to a power of two.
+  /// @param batch_size Maximum number of calls processed by a single pump().
+  thread_queue(std::size_t capacity = 4096, std::size_t batch_size = 256);
+
+  thread_queue(const thread_queue&) = delete;
+
+  ~thread_queue();
+
+  thread_queue& operator=(const thread_queue&) = delete;
+
+  /// Pushes a type-erased call.
+  /// The discard function, if any, is called instead of invoke when the call is coalesced
+  /// or when the queue is destroyed before the call was made.
+  ///
+  /// @returns false if the queue is full.
+  bool push(void* receiver, void* selector, invoke_ptr invoke, discard_ptr discard, const void* params,
+      std::size_t size, bool coalesce);
+
+  /// Pushes a call to a function taking (receiver, selector, params...).
+  template <typename... Params>
+  inline bool push(void* receiver, void* selector, void (*fct)(void*, void*, Params...), Params... params);
+
+  template <typename... Params>
+  inline bool push_coalesced(void* receiver, void* selector, void (*fct)(void*, void*, Params...), Params... params);
+
+#ifdef __APPLE__
+  /// Pushes a message to send on the consumer thread.
+  /// The receiver is retained until the message is sent or discarded.
+  template <typename SelectorType, typename... Params>
+  inline bool push(obj_t* receiver, SelectorType selector, Params... params);
+
+  template <typename SelectorType, typename... Params>
+  inline bool push_coalesced(obj_t* receiver, SelectorType selector, Params... params);
+
+  /// Drains the queue from a CFRunLoop source on the main run loop.
+  /// Must be called from the main thread.
+  void attach_to_main_run_loop();
+
+  void detach_from_run_loop();
+#endif // __APPLE__
+
+  /// Sets the function called when the queue goes from empty to non-empty.
+  /// Must be set before any producer starts pushing.
+  void set_wakeup(wakeup_ptr fct, void* data);
+
+  /// Processes at most one batch of calls. Must always be called from the same thread.
+  /// @returns The number of calls that were invoked.
+  std::size_t pump();
+
+  /// Processes batches until the queue is empty.
+  /// @returns The number of calls that were invoked.
+  std::size_t pump_all();
+
+  /// Number of calls pushed and not processed yet (approximation).
+  std::size_t size() const noexcept;
+
+  bool empty() const noexcept { return size() == 0; }
+
+  /// Number of calls that were dropped by coalescing.
+  std::size_t coalesced_count() const noexcept { return m_coalesced_count; }
+
+private:
+  struct request {
+    void* receiver;
+    void* selector;
+    invoke_ptr invoke;
+    discard_ptr discard;
+    bool coalesce;
+    alignas(std::max_align_t) unsigned char params[max_params_size];
+  };
+
+  struct cell {
+    std::atomic<std::size_t> sequence;
+    request req;
+  };
+
+  struct alignas(64) padded_index {
+    std::atomic<std::size_t> value = 0;
+  };
+
+  std::unique_ptr<cell[]> m_cells;
+  std::size_t m_mask;
+  padded_index m_tail;
+  padded_index m_head;
+  alignas(64) std::atomic<std::ptrdiff_t> m_pending = 0;
+
+  // Consumer only.
+  std::vector<request> m_batch;
+  std::vector<std::size_t> m_table;
+  std::size_t m_batch_size;
+  std::size_t m_coalesced_count = 0;
+
+  wakeup_ptr m_wakeup = nullptr;
+  void* m_wakeup_data = nullptr;
+  void* m_source = nullptr;
+
+  bool pop(request& req);
+
+  template <typename Pack>
+  static inline void invoke_fct(void* receiver, void* selector, const void* params);
+
+#ifdef __APPLE__
+  template <typename Pack>
+  static inline void invoke_msg(void* receiver, void* selector, const void* params);
+
+  static void release_receiver(void* receiver);
+
+  template <typename SelectorType, typename... Params>
+  inline bool push_msg(obj_t* receiver, SelectorType selector, bool coalesce, Params... params);
+#endif // __APPLE__
+};
+
+//
+//
+//
+
+namespace detail {
+  /// Trivially copyable parameters laid out in a raw buffer.
+  template <typename... Ts>
+  struct packed_params {
+    static_assert((std::is_trivially_copyable_v<Ts> && ...), "parameters must be trivially copyable");
+
+    static constexpr std::size_t count = sizeof...(Ts);
+
+    static constexpr std::array<std::size_t, count + 1> offsets = [] {
+      constexpr std::size_t sizes[] = { sizeof(Ts)..., 0 };
+      constexpr std::size_t aligns[] = { alignof(Ts)..., 1 };
+
+      std::array<std::size_t, count + 1> o = {};
+      std::size_t offset = 0;
+
+      for (std::size_t i = 0; i < count; i++) {
+        offset = (offset + aligns[i] - 1) & ~(aligns[i] - 1);
+        o[i] = offset;
+        offset += sizes[i];
+      }
+
+      o[count] = offset;
+      return o;
+    }();
+
+    static constexpr std::size_t size = offsets[count];
+
+    static inline void store(unsigned char* dst, const Ts&... ts) {
+      store_impl(dst, std::index_sequence_for<Ts...>{}, ts...);
+    }
+
+    template <typename Fct>
+    static inline void apply(const unsigned char* src, Fct&& fct) {
+      apply_impl(src, fct, std::index_sequence_for<Ts...>{});
+    }
+
+  private:
+    template <std::size_t... I>
+    static inline void store_impl([[maybe_unused]] unsigned char* dst, std::index_sequence<I...>, const Ts&... ts) {
+      (std::memcpy(dst + offsets[I], &ts, sizeof(Ts)), ...);
+    }
+
+    template <std::size_t I>
+    static inline auto load(const unsigned char* src) {
+      std::tuple_element_t<I, std::tuple<Ts...>> value;
+      std::memcpy(&value, src + offsets[I], sizeof(value));
+      return value;
+    }
+
+    template <typename Fct, std::size_t... I>
+    static inline void apply_impl([[maybe_unused]] const unsigned char* src, Fct& fct, std::index_sequence<I...>) {
+      fct(load<I>(src)...);
+    }
+  };
+} // namespace detail.
+
+template <typename Pack>
+void thread_queue::invoke_fct(void* receiver, void* selector, const void* params) {
+  Pack::apply(static_cast<const unsigned char*>(params), [&](auto fct, auto... args) { fct(receiver, selector, args...); });
+}
+
+template <typename... Params>
+bool thread_queue::push(void* receiver, void* selector, void (*fct)(void*, void*, Params...), Params... params) {
+  using pack_type = detail::packed_params<void (*)(void*, void*, Params...), Params...>;
+  static_assert(pack_type::size <= max_params_size, "too many parameters");
+
+  unsigned char buffer[pack_type::size];
+  pack_type::store(buffer, fct, params...);
+  return push(receiver, selector, &invoke_fct<pack_type>, nullptr, buffer, pack_type::size, false);
+}
+
+template <typename... Params>
+bool thread_queue::push_coalesced(
+    void* receiver, void* selector, void (*fct)(void*, void*, Params...), Params... params) {
+  using pack_type = detail::packed_params<void (*)(void*, void*, Params...), Params...>;
+  static_assert(pack_type::size <= max_params_size, "too many parameters");
+
+  unsigned char buffer[pack_type::size];
+  pack_type::store(buffer, fct, params...);
+  return push(receiver, selector, &invoke_fct<pack_type>, nullptr, buffer, pack_type::size, true);
+}
+
+#ifdef __APPLE__
+template <typename Pack>
+void thread_queue::invoke_msg(void* receiver, void* selector, const void* params) {
+  obj_t* obj = static_cast<obj_t*>(receiver);
+
+  Pack::apply(static_cast<const unsigned char*>(params), [&](auto... args) {
+    call<void, decltype(args)...>(obj, static_cast<selector_t*>(selector), args...);
+  });
+
+  release(obj);
+}
+
+template <typename SelectorType, typename... Params>
+bool thread_queue::push_msg(obj_t* receiver, SelectorType selector, bool coalesce, Params... params) {
+  using pack_type = detail::packed_params<null_to_obj<Params>...>;
+  static_assert(pack_type::size <= max_params_size, "too many parameters");
+
+  selector_t* sel = [](SelectorType s) {
+    if constexpr (std::is_same_v<SelectorType, selector_t*>) {
+      return s;
+    }
+    else {
+      return get_selector(s);
+    }
+  }(selector);
+
+  unsigned char buffer[pack_type::size + 1];
+  pack_type::store(buffer, params...);
+
+  retain(receiver);
+
+  // The receiver is passed as void* to call the type-erased push(), not push(obj_t*, SelectorType, Params...).
+  if (!push(static_cast<void*>(receiver), static_cast<void*>(sel), &invoke_msg<pack_type>, &release_receiver, buffer,
+          pack_type::size, coalesce)) {
+    release(receiver);
+    return false;
+  }
+
+  return true;
+}
+
+template <typename SelectorType, typename... Params>
+bool thread_queue::push(obj_t* receiver, SelectorType selector, Params... params) {
+  return push_msg(receiver, selector, false, params...);
+}
+
+template <typename SelectorType, typename... Params>
+bool thread_queue::push_coalesced(obj_t* receiver, SelectorType selector, Params... params) {
+  return push_msg(receiver, selector, true, params...);
+}
+#endif // __APPLE__
+
+} // namespace nano::objc.
+
+NANO_CLANG_DIAGNOSTIC_POP()
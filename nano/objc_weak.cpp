@@ -0,0 +1,79 @@
+#include <nano/objc_weak.h>
+
+#ifdef __APPLE__
+  #include <objc/objc.h>
+
+// Part of the objc runtime ABI used by ARC, not declared in the public headers.
+extern "C" {
+id objc_initWeak(id* location, id obj);
+id objc_storeWeak(id* location, id obj);
+id objc_loadWeakRetained(id* location);
+void objc_destroyWeak(id* location);
+void objc_copyWeak(id* to, id* from);
+void objc_moveWeak(id* to, id* from);
+}
+
+namespace nano::objc {
+weak_ptr::weak_ptr(obj_t* obj) { objc_initWeak(&m_location, obj); }
+
+weak_ptr::weak_ptr(const weak_ptr& other) { objc_copyWeak(&m_location, const_cast<obj_t**>(&other.m_location)); }
+
+weak_ptr::weak_ptr(weak_ptr&& other) noexcept {
+  objc_moveWeak(&m_location, const_cast<obj_t**>(&other.m_location));
+}
+
+weak_ptr::~weak_ptr() { objc_destroyWeak(&m_location); }
+
+weak_ptr& weak_ptr::operator=(obj_t* obj) {
+  objc_storeWeak(&m_location, obj);
+  return *this;
+}
+
+weak_ptr& weak_ptr::operator=(const weak_ptr& other) {
+  if (this != &other) {
+    obj_t* obj = objc_loadWeakRetained(const_cast<obj_t**>(&other.m_location));
+    objc_storeWeak(&m_location, obj);
+
+    if (obj) {
+      release(obj);
+    }
+  }
+
+  return *this;
+}
+
+weak_ptr& weak_ptr::operator=(weak_ptr&& other) noexcept {
+  if (this != &other) {
+    objc_destroyWeak(&m_location);
+    objc_moveWeak(&m_location, const_cast<obj_t**>(&other.m_location));
+  }
+
+  return *this;
+}
+
+void weak_ptr::reset() { objc_storeWeak(&m_location, nullptr); }
+
+obj_unique_ptr weak_ptr::lock() const { return obj_unique_ptr(objc_loadWeakRetained(const_cast<obj_t**>(&m_location))); }
+
+bool weak_ptr::expired() const {
+  obj_t* obj = objc_loadWeakRetained(const_cast<obj_t**>(&m_location));
+  if (!obj) {
+    return true;
+  }
+
+  release(obj);
+  return false;
+}
+
+std::size_t weak_ptr::lock_all(const weak_ptr* refs, std::size_t count, obj_t** out) {
+  std::size_t alive = 0;
+
+  for (std::size_t i = 0; i < count; i++) {
+    out[i] = objc_loadWeakRetained(const_cast<obj_t**>(&refs[i].m_location));
+    alive += out[i] != nullptr;
+  }
+
+  return alive;
+}
+} // namespace nano::objc.
+#endif // __APPLE__
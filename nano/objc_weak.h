@@ -0,0 +1,86 @@
+/*
+ * Nano Library
+ *
+ * Copyright (C) 2026, Meta-Sonic
+ * All rights reserved.
+ *
+ * Proprietary and confidential.
+ * Any unauthorized copying, alteration, distribution, transmission, performance,
+ * display or other use of this material is strictly prohibited.
+ */
+
+#pragma once
+
+/*!
+ * @file      nano/objc_weak.h
+ * @brief     nano objc zeroing weak references
+ * @copyright Copyright (C) 2026, Meta-Sonic
+ * @date      Created 18/10/2026
+ */
+
+#include <nano/objc.h>
+
+#ifdef __APPLE__
+  #include <cstddef>
+
+  #if __has_include(<span>)
+    #include <span>
+  #endif
+
+NANO_CLANG_DIAGNOSTIC_PUSH()
+NANO_CLANG_DIAGNOSTIC(warning, "-Weverything")
+NANO_CLANG_DIAGNOSTIC(ignored, "-Wc++98-compat")
+
+namespace nano::objc {
+
+/// A zeroing weak reference to an objc object (objc_storeWeak / objc_loadWeakRetained).
+///
+/// Holding a weak_ptr doesn't retain the object, it becomes nil when the object is deallocated.
+/// The runtime keeps track of the address of the reference, copies and moves go through the runtime as well.
+///
+/// @remarks The object must support weak references (i.e. allowsWeakReference returns true).
+class weak_ptr {
+public:
+  weak_ptr() noexcept = default;
+
+  weak_ptr(obj_t* obj);
+
+  weak_ptr(const weak_ptr& other);
+
+  weak_ptr(weak_ptr&& other) noexcept;
+
+  ~weak_ptr();
+
+  weak_ptr& operator=(obj_t* obj);
+
+  weak_ptr& operator=(const weak_ptr& other);
+
+  weak_ptr& operator=(weak_ptr&& other) noexcept;
+
+  void reset();
+
+  /// Returns a retained object, or nullptr if the object was deallocated.
+  obj_unique_ptr lock() const;
+
+  /// Returns true if the object was deallocated (or was never set).
+  bool expired() const;
+
+  /// Loads multiple references at once, e.g. to walk an observer list.
+  /// Each out[i] is a retained object (to be released by the caller) or nullptr.
+  /// @returns The number of objects that are still alive.
+  static std::size_t lock_all(const weak_ptr* refs, std::size_t count, obj_t** out);
+
+  #if defined(__cpp_lib_span)
+  static inline std::size_t lock_all(std::span<const weak_ptr> refs, std::span<obj_t*> out) {
+    return lock_all(refs.data(), std::min(refs.size(), out.size()), out.data());
+  }
+  #endif // __cpp_lib_span
+
+private:
+  obj_t* m_location = nullptr;
+};
+
+} // namespace nano::objc.
+
+NANO_CLANG_DIAGNOSTIC_POP()
+#endif // __APPLE__
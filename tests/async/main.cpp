@@ -0,0 +1,60 @@
+#include <nano/test.h>
+#include <nano/objc_async.h>
+#include <exception>
+
+#ifdef __APPLE__
+namespace {
+namespace objc = nano::objc;
+
+/// Coroutine starting eagerly and destroying itself when it returns.
+struct detached_task {
+  struct promise_type {
+    detached_task get_return_object() noexcept { return {}; }
+    std::suspend_never initial_suspend() noexcept { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() noexcept {}
+    void unhandled_exception() noexcept { std::terminate(); }
+  };
+};
+
+static_assert(objc::is_inline_executor<objc::inline_executor>);
+static_assert(!objc::is_inline_executor<objc::queue_executor>);
+
+struct async_descriptor {
+  static constexpr const char* baseName = "NSObject";
+  static constexpr const char* valueName = "__async";
+  static constexpr const char* className = "async_descriptor";
+};
+
+/// -(void)doubleValue:(int)value completion:(void (^)(int))completion, calls the completion handler before returning.
+void double_value(objc::obj_t*, objc::selector_t*, int value, objc::obj_t* completion) {
+  auto* block = reinterpret_cast<objc::block_literal<void, int>*>(completion);
+  block->invoke(block, value * 2);
+}
+
+detached_task sum_doubled_values(objc::obj_t* obj, int count, long& sum) {
+  for (int i = 0; i < count; i++) {
+    sum += co_await objc::async_call<int>(obj, "doubleValue:completion:", i);
+  }
+}
+
+TEST_CASE("nano.objc", AsyncCall, "Synchronous completion handler") {
+  objc::class_descriptor<async_descriptor> desc("AsyncTest");
+  desc.add_method<&double_value>("doubleValue:completion:", "v@:i@?");
+  desc.register_class();
+
+  objc::obj_t* obj = desc.create_instance();
+
+  // Each co_await completes before the message returns, the coroutine must not be resumed
+  // from within the completion handler or the stack would grow with every iteration.
+  constexpr int count = 1000000;
+  long sum = 0;
+  sum_doubled_values(obj, count, sum);
+  EXPECT_EQ(sum, static_cast<long>(count) * (count - 1));
+
+  objc::release(obj);
+}
+} // namespace
+#endif // __APPLE__
+
+NANO_TEST_MAIN()
@@ -1,9 +1,110 @@
 #include <nano/test.h>
 #include <nano/objc.h>
+#include <nano/objc_box.h>
+#include <nano/objc_data.h>
+#include <nano/objc_invoke.h>
+#include <nano/objc_thread_queue.h>
+#include <nano/objc_weak.h>
 #include <fstream>
+#include <thread>
 
 namespace {
 namespace objc = nano::objc;
+
+TEST_CASE("nano.objc", ThreadQueue, "Pump and coalesce") {
+  objc::thread_queue queue(64, 16);
+
+  std::size_t wakeups = 0;
+  queue.set_wakeup([](void* data) { ++*static_cast<std::size_t*>(data); }, &wakeups);
+
+  int value = 0;
+  auto set_value = [](void* receiver, void*, int v) { *static_cast<int*>(receiver) = v; };
+
+  for (int i = 0; i < 10; i++) {
+    EXPECT_TRUE(queue.push_coalesced(&value, nullptr, +set_value, i));
+  }
+
+  EXPECT_EQ(wakeups, 1UL);
+  EXPECT_EQ(queue.size(), 10UL);
+  EXPECT_EQ(queue.pump_all(), 1UL);
+  EXPECT_EQ(value, 9);
+  EXPECT_EQ(queue.coalesced_count(), 9UL);
+  EXPECT_TRUE(queue.empty());
+
+  std::size_t sum = 0;
+  auto add = [](void* receiver, void*, std::size_t v) { *static_cast<std::size_t*>(receiver) += v; };
+
+  std::vector<std::thread> producers;
+  for (int t = 0; t < 4; t++) {
+    producers.emplace_back([&]() {
+      for (std::size_t i = 0; i < 1000; i++) {
+        while (!queue.push(&sum, nullptr, +add, std::size_t(1))) {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+
+  std::size_t invoked = 0;
+  while (invoked < 4000) {
+    invoked += queue.pump();
+  }
+
+  for (std::thread& t : producers) {
+    t.join();
+  }
+
+  EXPECT_EQ(sum, 4000UL);
+  EXPECT_TRUE(queue.empty());
+}
+
+struct invoke_test_point {
+  double x, y;
+};
+
+double invoke_test_function(void*, void*, int a, invoke_test_point p, char c, float f) {
+  return a + p.x * 10 + p.y * 100 + c + static_cast<double>(f);
+}
+
+TEST_CASE("nano.objc", TypeEncoding, "Parse type encodings") {
+  objc::type_info info;
+  EXPECT_TRUE(objc::parse_type_encoding("{CGRect={CGPoint=dd}{CGSize=dd}}", info) != nullptr);
+  EXPECT_EQ(info.size, 32U);
+  EXPECT_EQ(info.alignment, 8U);
+  EXPECT_EQ(info.hfa_count, 4U);
+
+  EXPECT_EQ(objc::get_encoding_size("{?=c[3i]}"), 16UL);
+  EXPECT_EQ(objc::get_encoding_size("{_NSRange=QQ}"), 16UL);
+  EXPECT_EQ(objc::get_encoding_size("^{Foo=}"), sizeof(void*));
+  EXPECT_EQ(objc::get_encoding_size("{x=\"a\"c\"b\"@\"NSString\"}"), 16UL);
+  EXPECT_EQ(objc::get_encoding_size("{"), 0UL);
+
+  objc::method_signature sig("d44@0:8i16{invoke_test_point=dd}20c36f40");
+  EXPECT_TRUE(sig.valid());
+  EXPECT_EQ(sig.argument_count(), 6UL);
+  EXPECT_EQ(sig.argument_offset(3), 8UL);
+  EXPECT_EQ(sig.arguments_size(), 32UL);
+}
+
+TEST_CASE("nano.objc", DynamicInvoker, "Invoke from an arguments buffer") {
+  objc::method_signature sig("d@:i{invoke_test_point=dd}cf");
+  objc::dynamic_invoker::prepared_call call;
+  EXPECT_TRUE(objc::dynamic_invoker::prepare_signature(sig, call));
+  call.fct = reinterpret_cast<objc::dynamic_invoker::function_ptr>(&invoke_test_function);
+
+  struct {
+    int a;
+    invoke_test_point p;
+    char c;
+    float f;
+  } args = { 1, { 3, 4 }, -5, 0.25f };
+
+  double result = 0;
+  objc::dynamic_invoker::invoke(call, nullptr, &args, &result);
+  EXPECT_EQ(result, invoke_test_function(nullptr, nullptr, args.a, args.p, args.c, args.f));
+}
+
+#ifdef __APPLE__
 using id = objc::obj_t*;
 using objc::call;
 using objc::r_call;
@@ -55,6 +156,632 @@ TEST_CASE("nano.objc", ObjectiveC, "Call objc function") {
 
   EXPECT_STR_EQ("bingo.txt", to_cstr(r_call(fileArray, "objectAtIndex:", 0UL)));
 }
+
+TEST_CASE("nano.objc", ThreadQueueMessage, "Send queued messages") {
+  objc::thread_queue queue(64, 16);
+  objc::obj_unique_ptr array = objc::create_object("NSMutableArray", "init");
+  objc::obj_unique_ptr item = objc::create_object("NSObject", "init");
+
+  std::thread producer([&]() {
+    for (int i = 0; i < 3; i++) {
+      EXPECT_TRUE(queue.push(array.get(), "addObject:", item.get()));
+    }
+  });
+  producer.join();
+
+  EXPECT_EQ(queue.pump_all(), 3UL);
+  EXPECT_EQ(call<objc::ns_uint_t>(array, "count"), 3UL);
+
+  // Coalesced by (receiver, selector), only one object is removed.
+  for (int i = 0; i < 3; i++) {
+    EXPECT_TRUE(queue.push_coalesced(array.get(), objc::get_selector("removeLastObject")));
+  }
+
+  EXPECT_EQ(queue.pump_all(), 1UL);
+  EXPECT_EQ(call<objc::ns_uint_t>(array, "count"), 2UL);
+  EXPECT_TRUE(queue.empty());
+}
+
+struct coalescer_test {
+  static inline std::size_t count = 0;
+  static inline id payload = nullptr;
+  static inline std::thread::id thread;
+
+  static void deliver(id, id, id, id p, std::size_t n) {
+    count += n;
+    payload = p;
+    thread = std::this_thread::get_id();
+  }
+};
+
+TEST_CASE("nano.objc", EventCoalescer, "Deliver on the main run loop") {
+  objc::event_coalescer coalescer(&coalescer_test::deliver);
+  objc::obj_unique_ptr receiver = objc::create_object("NSObject", "init");
+  objc::obj_unique_ptr first = objc::create_object("NSObject", "init");
+  objc::obj_unique_ptr last = objc::create_object("NSObject", "init");
+  id name = from_cstr("event");
+
+  // Posted from a thread without a run loop.
+  std::thread poster([&]() {
+    for (int i = 0; i < 10; i++) {
+      coalescer.post(receiver.get(), name, nullptr, i < 9 ? first.get() : last.get());
+    }
+  });
+  poster.join();
+
+  id runLoop = objc::call_meta<id>("NSRunLoop", "mainRunLoop");
+  for (int i = 0; i < 100 && coalescer_test::count == 0; i++) {
+    call(runLoop, "runUntilDate:", objc::call_meta<id, double>("NSDate", "dateWithTimeIntervalSinceNow:", 0.01));
+  }
+
+  EXPECT_EQ(coalescer_test::count, 10UL);
+  EXPECT_TRUE(coalescer_test::payload == last.get());
+  EXPECT_TRUE(coalescer_test::thread == std::this_thread::get_id());
+}
+
+struct coalesced_test_descriptor {
+  static constexpr const char* baseName = "NSObject";
+  static constexpr const char* valueName = "__coalesced_test";
+  static constexpr const char* className = "coalesced_test_descriptor";
+
+  std::size_t count = 0;
+
+  void changed(id, std::size_t n) { count += n; }
+};
+
+TEST_CASE("nano.objc", CoalescedNotification, "Coalescing window per class") {
+  using desc_type = objc::class_descriptor<coalesced_test_descriptor>;
+  desc_type fast("FastCoalescedTestClass");
+  fast.add_coalesced_notification_method<&coalesced_test_descriptor::changed>("changed:");
+  fast.register_class();
+
+  desc_type slow("SlowCoalescedTestClass");
+  slow.add_coalesced_notification_method<&coalesced_test_descriptor::changed>("changed:", 60);
+  slow.register_class();
+
+  coalesced_test_descriptor fastValue;
+  coalesced_test_descriptor slowValue;
+  objc::obj_unique_ptr fastObj(fast.create_instance());
+  objc::obj_unique_ptr slowObj(slow.create_instance());
+  objc::set_ivar_pointer(fastObj.get(), coalesced_test_descriptor::valueName, &fastValue);
+  objc::set_ivar_pointer(slowObj.get(), coalesced_test_descriptor::valueName, &slowValue);
+
+  id notification
+      = objc::call_meta<id, id, id>("NSNotification", "notificationWithName:object:", from_cstr("changed"), nullptr);
+
+  for (int i = 0; i < 5; i++) {
+    call(fastObj.get(), "changed:", notification);
+    call(slowObj.get(), "changed:", notification);
+  }
+
+  id runLoop = objc::call_meta<id>("NSRunLoop", "mainRunLoop");
+  for (int i = 0; i < 100 && fastValue.count == 0; i++) {
+    call(runLoop, "runUntilDate:", objc::call_meta<id, double>("NSDate", "dateWithTimeIntervalSinceNow:", 0.01));
+  }
+
+  EXPECT_EQ(fastValue.count, 5UL);
+  EXPECT_EQ(slowValue.count, 0UL);
+}
+
+struct observed_test_descriptor {
+  static constexpr const char* baseName = "NSObject";
+  static constexpr const char* valueName = "__observed_test";
+  static constexpr const char* className = "observed_test_descriptor";
+};
+
+TEST_CASE("nano.objc", ObservedClass, "Only observed classes are kept") {
+  using desc_type = objc::class_descriptor<observed_test_descriptor>;
+  objc::class_t* observedClass = nullptr;
+  objc::class_t* unobservedClass = nullptr;
+  id obj = nullptr;
+
+  {
+    desc_type observed("ObservedTestClass");
+    observed.register_class();
+    observedClass = observed.get_class_object();
+
+    desc_type unobserved("UnobservedTestClass");
+    unobserved.register_class();
+    unobservedClass = unobserved.get_class_object();
+
+    obj = observed.create_instance();
+    objc::obj_unique_ptr observer = objc::create_object("NSObject", "init");
+    id keyPath = from_cstr("description");
+    call(obj, "addObserver:forKeyPath:options:context:", observer.get(), keyPath, objc::ns_uint_t(0), nullptr);
+    call(obj, "removeObserver:forKeyPath:", observer.get(), keyPath);
+
+    objc::release(unobserved.create_instance());
+  }
+
+  const std::vector<objc::class_t*> classes = objc::get_dynamic_classes();
+  EXPECT_TRUE(std::find(classes.begin(), classes.end(), observedClass) != classes.end());
+  EXPECT_TRUE(std::find(classes.begin(), classes.end(), unobservedClass) == classes.end());
+
+  // The slot of the observed class is cleared along with its last instance.
+  EXPECT_TRUE(desc_type::is_descriptor_class(observedClass));
+  objc::release(obj);
+  EXPECT_TRUE(!desc_type::is_descriptor_class(observedClass));
+}
+
+TEST_CASE("nano.objc", RegisteredClasses, "Any number of classes per descriptor") {
+  using desc_type = objc::class_descriptor<observed_test_descriptor>;
+  std::vector<std::unique_ptr<desc_type>> descriptors;
+
+  for (int i = 0; i < 40; i++) {
+    descriptors.push_back(std::make_unique<desc_type>("RegisteredTestClass"));
+    EXPECT_TRUE(descriptors.back()->register_class());
+  }
+
+  for (const std::unique_ptr<desc_type>& desc : descriptors) {
+    EXPECT_TRUE(desc_type::is_descriptor_class(desc->get_class_object()));
+  }
+
+  id obj = descriptors.back()->create_instance();
+  EXPECT_EQ(objc::get_class_memory_info(descriptors.back()->get_class_object()).live_instances, 1UL);
+  objc::release(obj);
+}
+
+struct invoker_test_descriptor {
+  static constexpr const char* baseName = "NSObject";
+  static constexpr const char* valueName = "__invoker_test";
+  static constexpr const char* className = "invoker_test_descriptor";
+};
+
+int first_value(id, objc::selector_t*) { return 1; }
+int second_value(id, objc::selector_t*) { return 2; }
+
+TEST_CASE("nano.objc", DynamicInvokerCache, "Prepared again when a class changed") {
+  objc::class_descriptor<invoker_test_descriptor> desc("InvokerTestClass");
+  desc.add_method<&first_value>("value", "i@:");
+  desc.register_class();
+
+  id obj = desc.create_instance();
+  objc::selector_t* sel = objc::get_selector("value");
+  objc::dynamic_invoker invoker;
+
+  int result = 0;
+  EXPECT_TRUE(invoker.invoke(obj, sel, nullptr, &result));
+  EXPECT_EQ(result, 1);
+
+  // Unrelated mutations keep the prepared call.
+  const objc::dynamic_invoker::prepared_call* call = invoker.prepare(desc.get_class_object(), sel);
+  objc::invalidate_runtime_caches();
+  EXPECT_TRUE(invoker.prepare(desc.get_class_object(), sel) == call);
+
+  objc::replace_class_method(desc.get_class_object(), sel, reinterpret_cast<objc::imp_ptr>(&second_value), "i@:");
+  EXPECT_TRUE(invoker.invoke(obj, sel, nullptr, &result));
+  EXPECT_EQ(result, 2);
+  EXPECT_TRUE(invoker.prepare(desc.get_class_object(), sel) != call);
+
+  objc::release(obj);
+}
+
+struct memory_test_descriptor {
+  static constexpr const char* baseName = "NSObject";
+  static constexpr const char* valueName = "__memory_test";
+  static constexpr const char* className = "memory_test_descriptor";
+};
+
+TEST_CASE("nano.objc", MemoryAccounting, "Dynamic class memory info") {
+  objc::class_descriptor<memory_test_descriptor> desc("MemoryTestClass");
+  EXPECT_TRUE(objc::add_class_variable<char>(desc.get_class_object(), "c", "c"));
+  EXPECT_TRUE(objc::add_class_variable<double>(desc.get_class_object(), "d", "d"));
+  desc.register_class();
+
+  objc::memory_snapshot before = objc::take_memory_snapshot();
+  id obj = desc.create_instance();
+  id obj2 = call<id>(call<id>(desc.get_class_object(), "alloc"), "init");
+
+  objc::class_memory_info info = objc::get_class_memory_info(desc.get_class_object());
+  EXPECT_EQ(info.ivars.size(), 3UL);
+  EXPECT_EQ(info.live_instances, 2UL);
+  EXPECT_EQ(info.padding, 7UL);
+
+  objc::memory_snapshot diff = objc::diff_memory_snapshots(before, objc::take_memory_snapshot());
+  EXPECT_EQ(diff.classes.size(), 1UL);
+  EXPECT_EQ(diff.live_instances(), 2);
+
+  // Classes of the same Descriptor are counted separately.
+  objc::class_descriptor<memory_test_descriptor> other("MemoryTestClass");
+  other.register_class();
+  id obj3 = other.create_instance();
+  EXPECT_EQ(objc::get_class_memory_info(other.get_class_object()).live_instances, 1UL);
+  EXPECT_EQ(objc::get_class_memory_info(desc.get_class_object()).live_instances, 2UL);
+
+  // Created without +alloc.
+  id obj4 = objc::create_object(objc::get_class_name(other.get_class_object()), "init");
+  EXPECT_EQ(objc::get_class_memory_info(other.get_class_object()).live_instances, 2UL);
+
+  objc::release(obj);
+  objc::release(obj2);
+  objc::release(obj3);
+  objc::release(obj4);
+  EXPECT_EQ(objc::diff_memory_snapshots(before, objc::take_memory_snapshot()).live_instances(), 0);
+  EXPECT_EQ(objc::get_class_memory_info(other.get_class_object()).live_instances, 0UL);
+}
+
+struct forwarding_test_descriptor {
+  static constexpr const char* baseName = "NSObject";
+  static constexpr const char* valueName = "__forwarding_test";
+  static constexpr const char* className = "forwarding_test_descriptor";
+
+  id target = from_cstr("forwarded");
+
+  id get_target() { return target; }
+};
+
+TEST_CASE("nano.objc", ForwardingTarget, "Forward to another object") {
+  objc::class_descriptor<forwarding_test_descriptor> desc("ForwardingTestClass");
+  EXPECT_TRUE(desc.add_forwarding_target<&forwarding_test_descriptor::get_target>({ "length", "UTF8String" }));
+  desc.register_class();
+
+  forwarding_test_descriptor value;
+  id obj = desc.create_instance();
+  objc::set_ivar_pointer(obj, forwarding_test_descriptor::valueName, &value);
+
+  EXPECT_EQ(call<objc::ns_uint_t>(obj, "length"), 9UL);
+  EXPECT_STR_EQ("forwarded", to_cstr(obj));
+  EXPECT_TRUE(call<bool>(obj, "respondsToSelector:", objc::get_selector("length")));
+  EXPECT_TRUE(!call<bool>(obj, "respondsToSelector:", objc::get_selector("count")));
+
+  // Forwarded selectors are per class.
+  objc::class_descriptor<forwarding_test_descriptor> other("ForwardingTestClass");
+  EXPECT_TRUE(other.add_forwarding_target<&forwarding_test_descriptor::get_target>({ "UTF8String" }));
+  other.register_class();
+
+  id otherObj = other.create_instance();
+  objc::set_ivar_pointer(otherObj, forwarding_test_descriptor::valueName, &value);
+
+  EXPECT_STR_EQ("forwarded", to_cstr(otherObj));
+  EXPECT_TRUE(!call<bool>(otherObj, "respondsToSelector:", objc::get_selector("length")));
+  EXPECT_TRUE(call<bool>(obj, "respondsToSelector:", objc::get_selector("length")));
+
+  objc::release(otherObj);
+  objc::release(obj);
+}
+
+struct handler_test_descriptor {
+  static constexpr const char* baseName = "NSObject";
+  static constexpr const char* valueName = "__handler_test";
+  static constexpr const char* className = "handler_test_descriptor";
+
+  int value = 0;
+
+  int add(int v) { return value += v; }
+};
+
+TEST_CASE("nano.objc", ForwardingHandler, "Forward to C++ handlers") {
+  objc::class_descriptor<handler_test_descriptor> desc("HandlerTestClass");
+  EXPECT_TRUE(desc.add_forwarding_handler<&handler_test_descriptor::add>("add:", "i@:i"));
+  desc.register_class();
+
+  handler_test_descriptor value;
+  id obj = desc.create_instance();
+  objc::set_ivar_pointer(obj, handler_test_descriptor::valueName, &value);
+
+  EXPECT_EQ(call<int>(obj, "add:", 2), 2);
+  EXPECT_EQ(call<int>(obj, "add:", 3), 5);
+  EXPECT_EQ(value.value, 5);
+
+  EXPECT_TRUE(call<bool>(obj, "respondsToSelector:", objc::get_selector("add:")));
+  EXPECT_TRUE(!objc::responds_to_selector(desc.get_class_object(), objc::get_selector("add:")));
+  objc::release(obj);
+}
+
+struct responds_base_test_descriptor {
+  static constexpr const char* baseName = "RespondsTestBase";
+  static constexpr const char* valueName = "__responds_base_test";
+  static constexpr const char* className = "responds_base_test_descriptor";
+
+  id target = from_cstr("forwarded");
+
+  id get_target() { return target; }
+};
+
+TEST_CASE("nano.objc", ForwardingBaseClass, "respondsToSelector: of the base class") {
+  // The base class reports a selector it handles dynamically.
+  objc::class_t* base = objc::allocate_class(objc::get_class("NSObject"), "RespondsTestBase");
+  objc::add_class_method(base, objc::get_selector("respondsToSelector:"),
+      reinterpret_cast<objc::imp_ptr>(+[](id obj, objc::selector_t*, objc::selector_t* sel) -> bool {
+        return sel == objc::get_selector("dynamicValue") || objc::responds_to_selector(objc::get_obj_class(obj), sel);
+      }),
+      "B@::");
+  objc::register_class(base);
+
+  {
+    objc::class_descriptor<responds_base_test_descriptor> desc("RespondsTestClass");
+    EXPECT_TRUE(desc.add_forwarding_target<&responds_base_test_descriptor::get_target>({ "length" }));
+    desc.register_class();
+
+    responds_base_test_descriptor value;
+    id obj = desc.create_instance();
+    objc::set_ivar_pointer(obj, responds_base_test_descriptor::valueName, &value);
+
+    EXPECT_TRUE(call<bool>(obj, "respondsToSelector:", objc::get_selector("dynamicValue")));
+    EXPECT_TRUE(call<bool>(obj, "respondsToSelector:", objc::get_selector("length")));
+    EXPECT_TRUE(!call<bool>(obj, "respondsToSelector:", objc::get_selector("count")));
+    objc::release(obj);
+  }
+
+  objc::dispose_class(base);
+}
+
+struct super_test_descriptor {
+  static constexpr const char* baseName = "NSObject";
+  static constexpr const char* valueName = "__super_test";
+  static constexpr const char* className = "super_test_descriptor";
+};
+
+TEST_CASE("nano.objc", SuperclassMessage, "Superclass implementations cached by selector") {
+  using desc_type = objc::class_descriptor<super_test_descriptor>;
+  desc_type desc("SuperTestClass");
+  desc.register_class();
+
+  id obj = desc.create_instance();
+
+  // The same buffer holds two selector names with the same signature.
+  char name[32] = "hash";
+  EXPECT_EQ(desc_type::send_superclass_message<objc::ns_uint_t>(obj, name), call<objc::ns_uint_t>(obj, "hash"));
+
+  std::strcpy(name, "retainCount");
+  EXPECT_EQ(desc_type::send_superclass_message<objc::ns_uint_t>(obj, name), 1UL);
+
+  std::strcpy(name, "hash");
+  EXPECT_EQ(desc_type::send_superclass_message<objc::ns_uint_t>(obj, name), call<objc::ns_uint_t>(obj, "hash"));
+
+  EXPECT_EQ(desc_type::send_superclass_message<objc::ns_uint_t>(obj, objc::get_selector("hash")),
+      call<objc::ns_uint_t>(obj, "hash"));
+
+  objc::release(obj);
+}
+
+struct lazy_test_descriptor {
+  static constexpr const char* baseName = "NSObject";
+  static constexpr const char* valueName = "__lazy_test";
+  static constexpr const char* className = "lazy_test_descriptor";
+
+  int value = 0;
+
+  int get_value() { return value; }
+
+  void set_value(int v) { value = v; }
+
+  void reset() { value = 0; }
+};
+
+TEST_CASE("nano.objc", LazyMethod, "Methods added on first use") {
+  objc::class_descriptor<lazy_test_descriptor> desc("LazyTestClass");
+  desc.add_lazy_method<&lazy_test_descriptor::get_value>("value", "i@:");
+  desc.add_lazy_method<&lazy_test_descriptor::set_value>("setValue:", "v@:i");
+  desc.add_lazy_method<&lazy_test_descriptor::reset>("reset", "v@:");
+  desc.register_class();
+
+  const std::size_t method_count = objc::get_class_memory_info(desc.get_class_object()).method_count;
+
+  lazy_test_descriptor value;
+  id obj = desc.create_instance();
+  objc::set_ivar_pointer(obj, lazy_test_descriptor::valueName, &value);
+
+  call(obj, "setValue:", 12);
+  EXPECT_EQ(call<int>(obj, "value"), 12);
+  EXPECT_EQ(objc::get_class_memory_info(desc.get_class_object()).method_count, method_count + 2);
+  EXPECT_TRUE(!objc::responds_to_selector(desc.get_class_object(), objc::get_selector("unknownLazyMethod")));
+
+  // Resolved from an instance of a subclass, the method is added to the descriptor class.
+  objc::class_t* subclass = objc::allocate_class(desc.get_class_object(), "LazyTestSubclass");
+  objc::register_class(subclass);
+
+  id sub = call<id>(call<id>(subclass, "alloc"), "init");
+  objc::set_ivar_pointer(sub, lazy_test_descriptor::valueName, &value);
+
+  call(sub, "reset");
+  EXPECT_EQ(value.value, 0);
+  EXPECT_EQ(objc::get_class_memory_info(subclass).method_count, 0UL);
+  EXPECT_EQ(objc::get_class_memory_info(desc.get_class_object()).method_count, method_count + 3);
+
+  objc::release(sub);
+  objc::release(obj);
+  objc::dispose_class(subclass);
+}
+
+struct conformance_test_descriptor {
+  static constexpr const char* baseName = "NSObject";
+  static constexpr const char* valueName = "__conformance_test";
+  static constexpr const char* className = "conformance_test_descriptor";
+};
+
+TEST_CASE("nano.objc", ConformanceCache, "Cached responds-to and conforms-to") {
+  static const objc::cached_selector value_sel = objc::register_cached_selector("cachedValue");
+  static const objc::cached_protocol copying = objc::register_cached_protocol("NSCopying");
+
+  objc::class_descriptor<conformance_test_descriptor> desc("ConformanceTestClass");
+  desc.register_class();
+
+  objc::class_t* c = desc.get_class_object();
+  EXPECT_TRUE(!objc::responds_to_selector(c, value_sel));
+  EXPECT_TRUE(!objc::conforms_to_protocol(c, copying));
+
+  EXPECT_TRUE(objc::add_class_method(c, value_sel.sel,
+      reinterpret_cast<objc::imp_ptr>(+[](id, objc::selector_t*) { return 1; }), "i@:"));
+  EXPECT_TRUE(desc.add_protocol("NSCopying"));
+
+  EXPECT_TRUE(objc::responds_to_selector(c, value_sel));
+  EXPECT_TRUE(objc::conforms_to_protocol(c, copying));
+  EXPECT_TRUE(objc::conforms_to_protocol(objc::get_class("NSString"), copying));
+}
+
+TEST_CASE("nano.objc", ConformanceCacheDisposed, "Entries of disposed classes are reused") {
+  static const objc::cached_selector value_sel = objc::register_cached_selector("cachedValue");
+
+  // More classes than the table holds, their addresses can be reused.
+  for (int i = 0; i < 2048; i++) {
+    objc::class_descriptor<conformance_test_descriptor> desc("DisposedConformanceTestClass");
+    desc.register_class();
+
+    objc::class_t* c = desc.get_class_object();
+    EXPECT_TRUE(!objc::responds_to_selector(c, value_sel));
+
+    if (i % 2) {
+      objc::add_class_method(
+          c, value_sel.sel, reinterpret_cast<objc::imp_ptr>(+[](id, objc::selector_t*) { return 1; }), "i@:");
+      EXPECT_TRUE(objc::responds_to_selector(c, value_sel));
+    }
+  }
+}
+
+TEST_CASE("nano.objc", Box, "Box and unbox numbers and values") {
+  id small = objc::box(12);
+  EXPECT_EQ(small, objc::box(12));
+  EXPECT_EQ(call<int>(small, "intValue"), 12);
+  EXPECT_EQ(objc::unbox<int>(small), 12);
+
+  id large = objc::box(1234567890123LL);
+  EXPECT_EQ(objc::unbox<long long>(large), 1234567890123LL);
+
+  int i = 0;
+  EXPECT_TRUE(!objc::unbox(large, i));
+
+  id huge = objc::box(~0ULL);
+  EXPECT_EQ(objc::unbox<unsigned long long>(huge), ~0ULL);
+
+  EXPECT_EQ(objc::unbox<double>(objc::box(2.5)), 2.5);
+  EXPECT_TRUE(objc::unbox<bool>(objc::box(true)));
+  EXPECT_EQ(objc::unbox<int>(objc::box(true)), 1);
+
+  struct range {
+    unsigned long location;
+    unsigned long length;
+  };
+
+  id value = objc::box(range{ 2, 3 }, "{_NSRange=QQ}");
+
+  range r = {};
+  EXPECT_TRUE(objc::unbox(value, r));
+  EXPECT_EQ(r.location, 2UL);
+  EXPECT_EQ(r.length, 3UL);
+  EXPECT_TRUE(!objc::unbox(small, r));
+  EXPECT_TRUE(!objc::unbox(from_cstr("12"), i));
+
+  for (id obj : { small, large, huge, value }) {
+    objc::release(obj);
+  }
+}
+
+TEST_CASE("nano.objc", DataView, "Zero-copy NSData") {
+  static std::byte buffer[] = { std::byte(1), std::byte(2), std::byte(3) };
+  static bool deallocated = false;
+
+  {
+    objc::data_view view = objc::data_view::wrap(buffer, sizeof(buffer),
+        [](void*, const std::byte* data, std::size_t size) { deallocated = data == buffer && size == 3; });
+
+    EXPECT_EQ(view.data(), buffer);
+    EXPECT_EQ(call<objc::ns_uint_t>(view.get(), "length"), 3UL);
+    EXPECT_EQ(call<const void*>(view.get(), "bytes"), static_cast<const void*>(buffer));
+
+    objc::data_view copy = objc::data_view(view.get());
+    EXPECT_EQ(copy.data(), buffer);
+    EXPECT_EQ(copy.size(), 3UL);
+  }
+
+  EXPECT_TRUE(deallocated);
+
+  std::vector<std::byte> bytes(1024, std::byte(7));
+  const std::byte* vector_data = bytes.data();
+  objc::data_view moved = objc::data_view::wrap(std::move(bytes));
+  EXPECT_EQ(moved.data(), vector_data);
+  EXPECT_EQ(moved[1023], std::byte(7));
+
+  const std::string path = "/tmp/nano_objc_data_view_test.txt";
+  std::ofstream(path) << "Bingo";
+
+  objc::data_view mapped = objc::data_view::map_file(path.c_str());
+  EXPECT_EQ(mapped.size(), 5UL);
+  EXPECT_TRUE(std::equal(mapped.begin(), mapped.end(), reinterpret_cast<const std::byte*>("Bingo")));
+  EXPECT_TRUE(!objc::data_view::map_file("/tmp/nano_objc_data_view_missing.txt"));
+}
+
+TEST_CASE("nano.objc", WeakPtr, "Zeroing weak references") {
+  id obj = objc::create_object("NSObject", "init");
+  id obj2 = objc::create_object("NSObject", "init");
+
+  std::vector<objc::weak_ptr> refs;
+  refs.emplace_back(obj);
+  refs.emplace_back(obj2);
+  refs.push_back(refs[0]);
+
+  EXPECT_EQ(objc::retain_count(obj), 1UL);
+  EXPECT_TRUE(refs[0].lock().get() == obj);
+  EXPECT_TRUE(!refs[2].expired());
+
+  objc::release(obj);
+  EXPECT_TRUE(refs[0].expired());
+  EXPECT_TRUE(refs[2].lock().get() == nullptr);
+
+  id locked[3] = {};
+  EXPECT_EQ(objc::weak_ptr::lock_all(refs.data(), refs.size(), locked), 1UL);
+  EXPECT_TRUE(locked[0] == nullptr && locked[1] == obj2 && locked[2] == nullptr);
+  objc::release(locked[1]);
+
+  objc::release(obj2);
+  EXPECT_TRUE(refs[1].expired());
+}
+
+struct direct_test_descriptor {
+  static constexpr const char* baseName = "NSObject";
+  static constexpr const char* valueName = "__direct_test";
+  static constexpr const char* className = "direct_test_descriptor";
+
+  int value = 0;
+
+  int add(int v) { return value += v; }
+
+  int get_value() const { return value; }
+};
+
+TEST_CASE("nano.objc", DescriptorRef, "Direct calls to descriptor members") {
+  objc::class_descriptor<direct_test_descriptor> desc("DirectTestClass");
+  desc.add_method<&direct_test_descriptor::add>("add:", "i@:i");
+  desc.add_method<&direct_test_descriptor::get_value>("value", "i@:");
+  desc.register_class();
+
+  direct_test_descriptor value;
+  id obj = desc.create_instance();
+  objc::set_ivar_pointer(obj, direct_test_descriptor::valueName, &value);
+
+  objc::descriptor_ref<direct_test_descriptor> ref(obj);
+  EXPECT_TRUE(ref.is_direct());
+  EXPECT_EQ(ref.call<&direct_test_descriptor::add>("add:", 2), 2);
+  EXPECT_EQ(ref.call<&direct_test_descriptor::get_value>("value"), 2);
+
+  // Key-value observing changes the class of the object, calls go through message dispatch.
+  objc::obj_unique_ptr observer = objc::create_object("NSObject", "init");
+  id keyPath = from_cstr("value");
+  call(obj, "addObserver:forKeyPath:options:context:", observer.get(), keyPath, objc::ns_uint_t(0), nullptr);
+  EXPECT_TRUE(!ref.is_direct());
+  EXPECT_EQ(ref.call<&direct_test_descriptor::add>("add:", 1), 3);
+  EXPECT_EQ(ref.call<&direct_test_descriptor::get_value>("value"), 3);
+
+  call(obj, "removeObserver:forKeyPath:", observer.get(), keyPath);
+  EXPECT_EQ(ref.call<&direct_test_descriptor::add>("add:", -1), 2);
+
+  // Instances of a subclass go through message dispatch.
+  objc::class_t* subclass = objc::allocate_class(desc.get_class_object(), "DirectTestSubclass");
+  objc::register_class(subclass);
+
+  id sub = call<id>(call<id>(subclass, "alloc"), "init");
+  objc::set_ivar_pointer(sub, direct_test_descriptor::valueName, &value);
+
+  objc::descriptor_ref<direct_test_descriptor> sub_ref(sub);
+  EXPECT_TRUE(!sub_ref.is_direct());
+  EXPECT_EQ(sub_ref.call<&direct_test_descriptor::add>(objc::get_selector("add:"), 3), 5);
+  EXPECT_EQ(sub_ref.call<&direct_test_descriptor::get_value>("value"), 5);
+
+  objc::release(sub);
+  objc::release(obj);
+  objc::dispose_class(subclass);
+}
+#endif // __APPLE__
 } // namespace
 
 NANO_TEST_MAIN()